@@ -0,0 +1,296 @@
+#include "Benchmark.hpp"
+#include "../DensityManager/DensityManager.hpp"
+#include "../MemoryTracker/MemoryTracker.hpp"
+#include "../ResultWriter/ResultWriter.hpp"
+#include "../Structure/Geometry/RectangleBatch.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <map>
+
+namespace
+{
+    double getSecond(const std::function<void()> &func)
+    {
+        auto startTime = std::chrono::high_resolution_clock::now();
+        func();
+        std::chrono::duration<double> second = std::chrono::high_resolution_clock::now() - startTime;
+        return second.count();
+    }
+
+    std::string toJsonString(const std::string &str)
+    {
+        std::string escaped = "\"";
+        for (char c : str)
+        {
+            if (c == '"' || c == '\\')
+                escaped += '\\';
+            escaped += c;
+        }
+        return escaped + "\"";
+    }
+}
+
+double Benchmark::Stage::getPercentile(double percent) const
+{
+    if (seconds.empty())
+        return 0;
+    std::vector<double> sorted(seconds);
+    std::sort(sorted.begin(), sorted.end());
+    size_t rank = static_cast<size_t>(std::ceil(percent / 100 * sorted.size()));
+    return sorted[std::max<size_t>(rank, 1) - 1];
+}
+
+void Benchmark::fillLayer(DensityManager &densityManager)
+{
+    // the same fill as DensityManager::solve() on a whole chip
+    densityManager.initGrid();
+    densityManager.fillAllTile();
+    if (densityManager.getMinMaxWindowMetalArea().first < densityManager.minMetalAreaConstraint)
+    {
+        densityManager.initGrid();
+        densityManager.fillRegion(densityManager.db->chipBoundary);
+    }
+}
+
+Benchmark::Benchmark(process::Database *db_, size_t numTileForWindow_)
+    : db(db_), numTileForWindow(numTileForWindow_) {}
+
+Benchmark::Stage Benchmark::measure(const std::string &name, size_t numWarmup, size_t numRepeat, const std::function<double()> &run)
+{
+    Stage stage{name, {}};
+    std::streambuf *coutBuffer = std::cout.rdbuf(nullptr);
+    for (size_t warmup = 0; warmup < numWarmup; ++warmup)
+        run();
+    for (size_t repeat = 0; repeat < numRepeat; ++repeat)
+        stage.seconds.emplace_back(run());
+    std::cout.rdbuf(coutBuffer);
+    std::cout.clear();
+    return stage;
+}
+
+void Benchmark::writeStageTable(std::ostream &output, const std::vector<Stage> &stages)
+{
+    char line[128];
+    output << "----- STAGE TIMES -----\n";
+    std::snprintf(line, sizeof(line), "%-24s%12s%12s\n", "stage", "median(ms)", "p95(ms)");
+    output << line;
+    for (const Stage &stage : stages)
+    {
+        std::snprintf(line, sizeof(line), "%-24s%12.3lf%12.3lf\n", stage.name.c_str(), 1000 * stage.getPercentile(50),
+                      1000 * stage.getPercentile(95));
+        output << line;
+    }
+    output << "\n";
+}
+
+void Benchmark::writeStageJson(std::ostream &output, const std::vector<std::pair<std::string, std::vector<Stage>>> &inputToStages,
+                               size_t numWarmup, size_t numRepeat)
+{
+    output << "{\n"
+           << "  \"geometry_kernel\": " << toJsonString(geometry::RectangleBatch::getKernelName()) << ",\n"
+           << "  \"warmups\": " << numWarmup << ",\n"
+           << "  \"repeats\": " << numRepeat << ",\n"
+           << "  \"inputs\": [";
+    for (size_t inputIdx = 0; inputIdx < inputToStages.size(); ++inputIdx)
+    {
+        const auto &[input, stages] = inputToStages[inputIdx];
+        output << ((inputIdx > 0) ? "," : "") << "\n    {\n"
+               << "      \"input\": " << toJsonString(input) << ",\n"
+               << "      \"stages\": [";
+        for (size_t stageIdx = 0; stageIdx < stages.size(); ++stageIdx)
+        {
+            const Stage &stage = stages[stageIdx];
+            output << ((stageIdx > 0) ? "," : "") << "\n        {\"name\": " << toJsonString(stage.name)
+                   << ", \"median_s\": " << stage.getPercentile(50) << ", \"p95_s\": " << stage.getPercentile(95) << ", \"seconds\": [";
+            for (size_t repeat = 0; repeat < stage.seconds.size(); ++repeat)
+                output << ((repeat > 0) ? ", " : "") << stage.seconds[repeat];
+            output << "]}";
+        }
+        output << "\n      ]\n    }";
+    }
+    output << "\n  ]\n}\n";
+}
+
+void Benchmark::runStages(std::vector<Stage> &stages, size_t numWarmup, size_t numRepeat, const std::string &scratchFilepath) const
+{
+    std::streambuf *coutBuffer = std::cout.rdbuf(nullptr);
+    DensityManager densityManager(db, numTileForWindow);
+    std::cout.rdbuf(coutBuffer);
+    std::cout.clear();
+
+    stages.emplace_back(measure("initGrid", numWarmup, numRepeat, [&]() -> double
+                                {
+                                    double second = 0;
+                                    for (const process::Layer::ptr &layer : db->layers)
+                                    {
+                                        densityManager.initProcessLayer(layer.get());
+                                        second += getSecond([&]() { densityManager.initGrid(); });
+                                    }
+                                    return second;
+                                }));
+
+    // the per-tile kernels run on every tile, except getConductorArea() which the solver calls on the mixed tiles only
+    std::vector<std::vector<geometry::CompactRectangle>> tileToRegions;
+    std::vector<geometry::CompactRectangle> regions, fillers; // reused across tiles
+    auto runPerTile = [&](const std::function<void()> &prepare, const std::function<void(size_t, size_t, size_t)> &func) -> double
+    {
+        double second = 0;
+        for (const process::Layer::ptr &layer : db->layers)
+        {
+            densityManager.initProcessLayer(layer.get());
+            densityManager.initGrid();
+            prepare();
+            second += getSecond([&]()
+                                {
+                                    size_t tileIdx = 0;
+                                    for (size_t rowIdx = 0; rowIdx < densityManager.numTileRow; ++rowIdx)
+                                        for (size_t colIdx = 0; colIdx < densityManager.numTileCol; ++colIdx)
+                                            func(rowIdx, colIdx, tileIdx++);
+                                });
+        }
+        return second;
+    };
+    auto sweepAllTile = [&]()
+    {
+        tileToRegions.assign(densityManager.numTileRow * densityManager.numTileCol, {});
+        size_t tileIdx = 0;
+        for (size_t rowIdx = 0; rowIdx < densityManager.numTileRow; ++rowIdx)
+            for (size_t colIdx = 0; colIdx < densityManager.numTileCol; ++colIdx)
+                densityManager.getAllFreeRegion(rowIdx, colIdx, tileToRegions[tileIdx++]);
+    };
+    auto refineAllTile = [&]()
+    {
+        sweepAllTile();
+        for (std::vector<geometry::CompactRectangle> &tileRegions : tileToRegions)
+        {
+            densityManager.refineFreeRegion(tileRegions, regions);
+            tileRegions.swap(regions);
+        }
+    };
+
+    int64_t conductorArea = 0;
+    stages.emplace_back(measure("getConductorArea", numWarmup, numRepeat, [&]() -> double
+                                {
+                                    return runPerTile([]() {}, [&](size_t rowIdx, size_t colIdx, size_t)
+                                                      {
+                                                          const process::Tile &tile = densityManager.tileGrid[rowIdx][colIdx];
+                                                          if (tile.kind == process::Tile::Kind::MIXED)
+                                                              conductorArea += densityManager.getConductorArea(tile);
+                                                      });
+                                }));
+    stages.emplace_back(measure("getAllFreeRegion", numWarmup, numRepeat, [&]() -> double
+                                {
+                                    return runPerTile([]() {}, [&](size_t rowIdx, size_t colIdx, size_t)
+                                                      { densityManager.getAllFreeRegion(rowIdx, colIdx, regions); });
+                                }));
+    stages.emplace_back(measure("refineFreeRegion", numWarmup, numRepeat, [&]() -> double
+                                {
+                                    return runPerTile(sweepAllTile, [&](size_t, size_t, size_t tileIdx)
+                                                      { densityManager.refineFreeRegion(tileToRegions[tileIdx], regions); });
+                                }));
+    stages.emplace_back(measure("generateAllFiller", numWarmup, numRepeat, [&]() -> double
+                                {
+                                    return runPerTile(refineAllTile, [&](size_t, size_t, size_t tileIdx)
+                                                      { densityManager.generateAllFiller(tileToRegions[tileIdx], fillers); });
+                                }));
+    tileToRegions.clear();
+    tileToRegions.shrink_to_fit();
+
+    // each removal pass starts from the state the passes before it leave in DensityManager::solve()
+    std::vector<std::pair<std::string, std::function<void()>>> passes = {
+        {"removeCriticalNetFiller", [&]() { densityManager.removeCriticalNetFiller(); }},
+        {"meetDensityConstraint", [&]() { densityManager.meetDensityConstraint(); }},
+        {"removeMoreFiller", [&]() { densityManager.removeMoreFiller(); }}};
+    for (size_t passIdx = 0; passIdx < passes.size(); ++passIdx)
+    {
+        stages.emplace_back(measure(passes[passIdx].first, numWarmup, numRepeat, [&]() -> double
+                                    {
+                                        double second = 0;
+                                        for (const process::Layer::ptr &layer : db->layers)
+                                        {
+                                            densityManager.initProcessLayer(layer.get());
+                                            fillLayer(densityManager);
+                                            for (size_t prevIdx = 0; prevIdx < passIdx; ++prevIdx)
+                                                passes[prevIdx].second();
+                                            second += getSecond(passes[passIdx].second);
+                                        }
+                                        return second;
+                                    }));
+    }
+
+    // the writer gets the fillers left by the removal passes
+    ResultWriter resultWriter(db->originX, db->originY);
+    for (const process::Layer::ptr &layer : db->layers)
+    {
+        densityManager.initProcessLayer(layer.get());
+        fillLayer(densityManager);
+        for (const auto &[_, pass] : passes)
+            pass();
+        for (const process::Filler *filler : densityManager.getAllInsertedFiller())
+            resultWriter.addFiller(*filler, layer->id);
+    }
+    stages.emplace_back(measure("ResultWriter::write", numWarmup, numRepeat, [&]() -> double
+                                { return getSecond([&]() { resultWriter.write(scratchFilepath); }); }));
+    std::remove(scratchFilepath.c_str());
+}
+
+void Benchmark::runSweep(std::ostream &output, size_t numRepeat) const
+{
+    DensityManager densityManager(db, numTileForWindow);
+    std::map<process::Layer::Direction, std::pair<size_t, double>> directionToRecord; // {direction, (#tiles, second)}
+    size_t numRegion = 0;
+    size_t numSteadyAllocation = 0, numSteadyTile = 0;
+    std::vector<geometry::CompactRectangle> freeRegions, refinedRegions; // reused across tiles
+    for (const process::Layer::ptr &layer : db->layers)
+    {
+        densityManager.initProcessLayer(layer.get());
+        densityManager.initGrid();
+
+        // the first repeat warms up the scratch buffers, the allocations are counted from the second one on
+        size_t numBeginAllocation = MemoryTracker::getNumAllocation();
+        auto startTime = std::chrono::high_resolution_clock::now();
+        for (size_t repeat = 0; repeat < numRepeat; ++repeat)
+        {
+            if (repeat == 1)
+                numBeginAllocation = MemoryTracker::getNumAllocation();
+            for (size_t rowIdx = 0; rowIdx < densityManager.numTileRow; ++rowIdx)
+            {
+                for (size_t colIdx = 0; colIdx < densityManager.numTileCol; ++colIdx)
+                {
+                    densityManager.getAllFreeRegion(rowIdx, colIdx, freeRegions);
+                    densityManager.refineFreeRegion(freeRegions, refinedRegions);
+                    numRegion += refinedRegions.size();
+                }
+            }
+        }
+        std::chrono::duration<double> second = std::chrono::high_resolution_clock::now() - startTime;
+
+        auto &[numTile, totalSecond] = directionToRecord[layer->direction];
+        numTile += numRepeat * densityManager.numTileRow * densityManager.numTileCol;
+        totalSecond += second.count();
+        if (numRepeat > 1)
+        {
+            numSteadyAllocation += MemoryTracker::getNumAllocation() - numBeginAllocation;
+            numSteadyTile += (numRepeat - 1) * densityManager.numTileRow * densityManager.numTileCol;
+        }
+    }
+
+    output << "----- SWEEP THROUGHPUT -----\n";
+    output << "Geometry kernel: " << geometry::RectangleBatch::getKernelName() << "\n";
+    for (const auto &[direction, record] : directionToRecord)
+    {
+        process::Layer layer;
+        layer.direction = direction;
+        output << layer.directionName() << ": " << record.first << " tiles in " << record.second << " s, "
+               << record.first / record.second << " tiles/s\n";
+    }
+    output << "#refined regions: " << numRegion << "\n";
+    if (!MemoryTracker::isCountingAllocation())
+        output << "#allocations per tile: N/A (build with COUNT_ALLOCATION=1)\n";
+    else if (numSteadyTile > 0)
+        output << "#allocations per tile: " << static_cast<double>(numSteadyAllocation) / numSteadyTile << "\n";
+    output << "\n";
+}
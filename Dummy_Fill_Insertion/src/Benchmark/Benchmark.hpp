@@ -0,0 +1,37 @@
+#pragma once
+#include "../Structure/Process/Process.hpp"
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class DensityManager;
+
+class Benchmark
+{
+public:
+    struct Stage
+    {
+        std::string name;
+        std::vector<double> seconds; // one per repeat, the warm-ups excluded
+
+        double getPercentile(double percent) const; // nearest rank
+    };
+
+private:
+    process::Database *db;
+    size_t numTileForWindow;
+
+    static void fillLayer(DensityManager &densityManager);
+
+public:
+    Benchmark(process::Database *db_, size_t numTileForWindow_ = 4);
+    // run() returns the seconds of its timed part, the standard output is muted meanwhile
+    static Stage measure(const std::string &name, size_t numWarmup, size_t numRepeat, const std::function<double()> &run);
+    static void writeStageTable(std::ostream &output, const std::vector<Stage> &stages);
+    static void writeStageJson(std::ostream &output, const std::vector<std::pair<std::string, std::vector<Stage>>> &inputToStages,
+                               size_t numWarmup, size_t numRepeat);
+    // the stages after the database is created, on every layer per repeat
+    void runStages(std::vector<Stage> &stages, size_t numWarmup, size_t numRepeat, const std::string &scratchFilepath) const;
+    void runSweep(std::ostream &output, size_t numRepeat) const;
+};
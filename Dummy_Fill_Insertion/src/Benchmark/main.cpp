@@ -0,0 +1,82 @@
+#include "../Parser/Parser.hpp"
+#include "Benchmark.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <unistd.h>
+
+int main(int argc, char *argv[])
+{
+    size_t numWarmup = 1, numRepeat = 5;
+    std::string jsonFilepath;
+    int opt;
+    while ((opt = getopt(argc, argv, "hw:r:o:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'w':
+            numWarmup = std::atoi(optarg);
+            break;
+        case 'r':
+            numRepeat = std::atoi(optarg);
+            break;
+        case 'o':
+            jsonFilepath = optarg;
+            break;
+        default:
+            optind = argc + 1;
+            break;
+        }
+    }
+    if (optind >= argc || numRepeat == 0)
+    {
+        std::cerr << "Usage: " << argv[0] << " [-w <#warm-ups>] [-r <#repeats>] [-o <JSON file>] <input file>...\n";
+        return 1;
+    }
+
+    std::vector<std::pair<std::string, std::vector<Benchmark::Stage>>> inputToStages;
+    for (int i = optind; i < argc; ++i)
+    {
+        std::string inputFilepath = argv[i];
+        std::vector<Benchmark::Stage> stages;
+        stages.emplace_back(Benchmark::measure("Parser::parse", numWarmup, numRepeat, [&]() -> double
+                                               {
+                                                   Parser parser;
+                                                   auto startTime = std::chrono::high_resolution_clock::now();
+                                                   parser.parse(inputFilepath);
+                                                   std::chrono::duration<double> second = std::chrono::high_resolution_clock::now() - startTime;
+                                                   return second.count();
+                                               }));
+
+        Parser parser;
+        if (!parser.parse(inputFilepath))
+            return 1;
+        stages.emplace_back(Benchmark::measure("Parser::createDatabase", numWarmup, numRepeat, [&]() -> double
+                                               {
+                                                   auto startTime = std::chrono::high_resolution_clock::now();
+                                                   process::Database::ptr db = parser.createDatabase();
+                                                   std::chrono::duration<double> second = std::chrono::high_resolution_clock::now() - startTime;
+                                                   return second.count();
+                                               }));
+        process::Database::ptr db = parser.createDatabase();
+
+        Benchmark benchmark(db.get());
+        benchmark.runStages(stages, numWarmup, numRepeat, (jsonFilepath.empty() ? "bench" : jsonFilepath) + ".fill.txt");
+        benchmark.runSweep(std::cout, numRepeat);
+        Benchmark::writeStageTable(std::cout, stages);
+        inputToStages.emplace_back(inputFilepath, std::move(stages));
+    }
+
+    if (!jsonFilepath.empty())
+    {
+        std::ofstream fout(jsonFilepath);
+        if (!fout)
+        {
+            std::cerr << "[Error] Cannot open \"" << jsonFilepath << "\".\n";
+            return 1;
+        }
+        Benchmark::writeStageJson(fout, inputToStages, numWarmup, numRepeat);
+    }
+    return 0;
+}
@@ -0,0 +1,281 @@
+#include "Coordinator.hpp"
+#include "../DensityManager/DensityManager.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <iostream>
+#include <limits>
+#include <poll.h>
+#include <signal.h>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+geometry::Rectangle Coordinator::getRowRegion(size_t beginRowIdx, size_t endRowIdx) const
+{
+    // the last row absorbs the remainder of the chip height
+    auto getRowY = [&](size_t rowIdx) -> int64_t
+    {
+        return db->originY + ((rowIdx == numTileRow) ? db->chipBoundary.y2 : static_cast<int64_t>(rowIdx) * tileSize);
+    };
+    return geometry::Rectangle(db->originX + db->chipBoundary.x1, getRowY(beginRowIdx),
+                               db->originX + db->chipBoundary.x2, getRowY(endRowIdx));
+}
+
+Coordinator::LayerToFillers Coordinator::solveTask(const Task &task, int timeLimit) const
+{
+    process::Database::ptr regionDb = parser->createDatabase(task.loadRegion);
+    regionDb->isIncremental = true;
+    regionDb->isPartial = true;
+    regionDb->windowBoundary = regionDb->toRelative(task.windowRegion);
+
+    // refill exactly the refill rows, markDirtyTile() expands the changed region by the spacing
+    for (process::Layer::ptr &layer : regionDb->layers)
+    {
+        geometry::CompactRectangle changedRegion = regionDb->toRelative(task.refillRegion);
+        changedRegion.expand(0, -layer->minSpacing, 0, -layer->minSpacing);
+        layer->changedRegions.emplace_back(changedRegion);
+        auto it = task.previousFillers.find(layer->id);
+        if (it != task.previousFillers.end())
+            for (const geometry::Rectangle &filler : it->second)
+                layer->previousFillers.emplace_back(regionDb->toRelative(filler));
+    }
+
+    Timer taskTimer(timeLimit);
+    DensityManager densityManager(regionDb.get(), numTileForWindow, &taskTimer);
+    return densityManager.solve()->takeFillers(std::numeric_limits<int64_t>::min());
+}
+
+std::vector<Coordinator::LayerToFillers> Coordinator::solveTasks(const std::vector<Task> &tasks, const std::string &name, double timeRatio)
+{
+    std::vector<LayerToFillers> results(tasks.size());
+    size_t numBatch = (tasks.size() + numWorker - 1) / numWorker;
+    for (size_t beginIdx = 0; beginIdx < tasks.size(); beginIdx += numWorker)
+    {
+        size_t endIdx = std::min(beginIdx + numWorker, tasks.size());
+        int timeLimit = 10 * 60;
+        auto deadline = std::chrono::steady_clock::time_point::max();
+        if (timer)
+        {
+            auto remainingTime = std::chrono::duration_cast<std::chrono::seconds>(timer->getRemainingTime());
+            size_t numRemainBatch = numBatch - beginIdx / numWorker;
+            timeLimit = std::max(static_cast<int>(remainingTime.count() * timeRatio / numRemainBatch), 1);
+            deadline = std::chrono::steady_clock::now() + std::max<std::chrono::milliseconds>(timer->getRemainingTime(), minWorkerWait);
+        }
+        auto getWaitTime = [&]() -> int
+        {
+            if (deadline == std::chrono::steady_clock::time_point::max())
+                return -1;
+            auto waitTime = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+            return static_cast<int>(std::clamp<int64_t>(waitTime.count(), 0, std::numeric_limits<int>::max()));
+        };
+
+        // the output buffered so far must not be written again by the children
+        std::cout.flush();
+        std::fflush(stdout);
+
+        std::vector<pid_t> pids(endIdx - beginIdx, -1);
+        std::vector<int> fds(endIdx - beginIdx, -1);
+        for (size_t idx = beginIdx; idx < endIdx; ++idx)
+        {
+            int fd[2];
+            if (pipe(fd) != 0)
+                continue;
+
+            pid_t pid = fork();
+            if (pid == 0)
+            {
+                close(fd[0]);
+                if (!std::freopen("/dev/null", "w", stdout))
+                    _exit(1);
+
+                std::vector<Record> records;
+                for (const auto &[layerId, fillers] : solveTask(tasks[idx], timeLimit))
+                    for (const geometry::Rectangle &filler : fillers)
+                        records.push_back({layerId, filler.x1, filler.y1, filler.x2, filler.y2});
+
+                const char *buffer = reinterpret_cast<const char *>(records.data());
+                size_t numByte = records.size() * sizeof(Record);
+                while (numByte > 0)
+                {
+                    ssize_t numWritten = write(fd[1], buffer, numByte);
+                    if (numWritten < 0 && errno == EINTR)
+                        continue;
+                    if (numWritten <= 0)
+                        _exit(1);
+                    buffer += numWritten;
+                    numByte -= numWritten;
+                }
+                close(fd[1]);
+                _exit(0);
+            }
+
+            close(fd[1]);
+            if (pid < 0)
+            {
+                close(fd[0]);
+                continue;
+            }
+            pids[idx - beginIdx] = pid;
+            fds[idx - beginIdx] = fd[0];
+        }
+
+        for (size_t idx = beginIdx; idx < endIdx; ++idx)
+        {
+            pid_t pid = pids[idx - beginIdx];
+            int fd = fds[idx - beginIdx];
+            std::string bytes;
+            bool isSucceeded = (pid > 0), isTimedOut = false;
+            if (pid > 0)
+            {
+                char buffer[1 << 16];
+                while (true)
+                {
+                    pollfd pollFd = {fd, POLLIN, 0};
+                    int numReady = poll(&pollFd, 1, getWaitTime());
+                    if (numReady < 0 && errno == EINTR)
+                        continue;
+                    isTimedOut = (numReady == 0);
+                    if (numReady <= 0)
+                        break;
+
+                    ssize_t numRead = read(fd, buffer, sizeof(buffer));
+                    if (numRead < 0 && errno == EINTR)
+                        continue;
+                    if (numRead <= 0)
+                        break;
+                    bytes.append(buffer, numRead);
+                }
+                close(fd);
+
+                // the worker closes the pipe right before it exits, but a hung one is not waited for past the deadline
+                int status = 0;
+                pid_t waitedPid = 0;
+                while (!isTimedOut && (waitedPid = waitpid(pid, &status, WNOHANG)) == 0)
+                {
+                    if (getWaitTime() == 0)
+                        isTimedOut = true;
+                    else
+                        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                }
+                if (isTimedOut)
+                {
+                    kill(pid, SIGKILL);
+                    waitpid(pid, &status, 0);
+                }
+                isSucceeded = !isTimedOut && waitedPid == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0 &&
+                              bytes.size() % sizeof(Record) == 0;
+            }
+
+            if (isSucceeded)
+            {
+                const Record *records = reinterpret_cast<const Record *>(bytes.data());
+                for (size_t i = 0; i < bytes.size() / sizeof(Record); ++i)
+                    results[idx][records[i].layerId].emplace_back(records[i].x1, records[i].y1, records[i].x2, records[i].y2);
+            }
+            else if (isTimedOut)
+            {
+                // past the time limit, only the mandatory passes are run
+                std::cout << "[Warning] Worker of " << name << " " << idx << " exceeded the time limit and was killed. Solve it in the coordinator.\n";
+                results[idx] = solveTask(tasks[idx], 1);
+            }
+            else
+            {
+                std::cout << "[Warning] Worker of " << name << " " << idx << " failed. Solve it in the coordinator.\n";
+                results[idx] = solveTask(tasks[idx], timeLimit);
+            }
+
+            size_t numFiller = 0;
+            for (const auto &[_, fillers] : results[idx])
+                numFiller += fillers.size();
+            std::cout << "Finish " << name << " " << idx << ", y range: " << tasks[idx].refillRegion.y1 << " "
+                      << tasks[idx].refillRegion.y2 << ", #fillers: " << numFiller << "\n";
+        }
+    }
+    return results;
+}
+
+Coordinator::Coordinator(const Parser *parser_, const process::Database *db_, size_t numTileForWindow_, size_t numWorker_, Timer *timer_)
+    : parser(parser_), db(db_), numTileForWindow(numTileForWindow_), numWorker(std::max<size_t>(numWorker_, 1)), timer(timer_),
+      tileSize(db->windowSize / numTileForWindow),
+      numTileRow(db->chipBoundary.height() / tileSize) {}
+
+ResultWriter::ptr Coordinator::solve()
+{
+    // a seam reads n - 1 rows beyond its refilled rows on each side, its dirty tiles another n - 1 rows,
+    // and the windows checked by it another n - 1 rows, so a region needs 6(n - 1) rows to keep the seams apart
+    size_t haloRow = numTileForWindow - 1;
+    size_t numRegion = std::max<size_t>(std::min(numWorker, numTileRow / (6 * haloRow)), 1);
+    int64_t maxFillWidth = 0;
+    for (const process::Layer::ptr &layer : db->layers)
+        maxFillWidth = std::max(maxFillWidth, layer->maxFillWidth);
+    size_t numContextRow = (maxFillWidth + tileSize - 1) / tileSize;
+
+    std::vector<size_t> regionBeginRowIdxs;
+    for (size_t regionIdx = 0; regionIdx <= numRegion; ++regionIdx)
+        regionBeginRowIdxs.emplace_back(regionIdx * numTileRow / numRegion);
+
+    std::cout << "----- COORDINATOR -----\n"
+              << "#workers: " << numWorker << "\n"
+              << "#regions: " << numRegion << "\n";
+
+    // each region is filled on its own rows, with one row around for the conductors within spacing distance
+    std::vector<Task> regionTasks(numRegion);
+    for (size_t regionIdx = 0; regionIdx < numRegion; ++regionIdx)
+    {
+        size_t beginRowIdx = regionBeginRowIdxs[regionIdx], endRowIdx = regionBeginRowIdxs[regionIdx + 1];
+        Task &task = regionTasks[regionIdx];
+        task.refillRegion = task.windowRegion = getRowRegion(beginRowIdx, endRowIdx);
+        task.loadRegion = getRowRegion((beginRowIdx > 0) ? beginRowIdx - 1 : 0, std::min(endRowIdx + 1, numTileRow));
+    }
+    std::vector<LayerToFillers> regionResults = solveTasks(regionTasks, "region", 2.0 / 3.0); // the rest is left to the seams
+
+    // each seam refills the rows around a region boundary, the fillers of both regions are its previous fillers
+    std::vector<Task> seamTasks(numRegion - 1);
+    std::vector<geometry::Rectangle> seamDirtyRegions(numRegion - 1);
+    for (size_t seamIdx = 0; seamIdx + 1 < numRegion; ++seamIdx)
+    {
+        size_t boundaryRowIdx = regionBeginRowIdxs[seamIdx + 1];
+        Task &task = seamTasks[seamIdx];
+        task.refillRegion = getRowRegion(boundaryRowIdx - haloRow, boundaryRowIdx + haloRow);
+        task.windowRegion = getRowRegion(boundaryRowIdx - 3 * haloRow, boundaryRowIdx + 3 * haloRow);
+        task.loadRegion = getRowRegion((boundaryRowIdx > 3 * haloRow + numContextRow) ? boundaryRowIdx - 3 * haloRow - numContextRow : 0,
+                                       std::min(boundaryRowIdx + 3 * haloRow + numContextRow, numTileRow));
+        seamDirtyRegions[seamIdx] = getRowRegion(boundaryRowIdx - 2 * haloRow, boundaryRowIdx + 2 * haloRow);
+        for (size_t regionIdx = seamIdx; regionIdx <= seamIdx + 1; ++regionIdx)
+            for (const auto &[layerId, fillers] : regionResults[regionIdx])
+                for (const geometry::Rectangle &filler : fillers)
+                    if (filler.y1 >= task.loadRegion.y1 && filler.y2 <= task.loadRegion.y2)
+                        task.previousFillers[layerId].emplace_back(filler);
+    }
+    std::vector<LayerToFillers> seamResults = solveTasks(seamTasks, "seam", 1.0);
+    std::cout << "\n";
+
+    // a filler reaching the dirty rows of a seam is decided by the seam, the others by their region
+    auto isInSeam = [](const geometry::Rectangle &filler, const geometry::Rectangle &seamDirtyRegion) -> bool
+    {
+        return filler.y2 > seamDirtyRegion.y1 && filler.y1 < seamDirtyRegion.y2;
+    };
+    ResultWriter *resultWriter = new ResultWriter(db->originX, db->originY);
+    for (const LayerToFillers &regionResult : regionResults)
+    {
+        for (const auto &[layerId, fillers] : regionResult)
+        {
+            for (const geometry::Rectangle &filler : fillers)
+            {
+                bool isDecidedBySeam = false;
+                for (const geometry::Rectangle &seamDirtyRegion : seamDirtyRegions)
+                    isDecidedBySeam = isDecidedBySeam || isInSeam(filler, seamDirtyRegion);
+                if (!isDecidedBySeam)
+                    resultWriter->addFiller(db->toRelative(filler), layerId);
+            }
+        }
+    }
+    for (size_t seamIdx = 0; seamIdx < seamResults.size(); ++seamIdx)
+        for (const auto &[layerId, fillers] : seamResults[seamIdx])
+            for (const geometry::Rectangle &filler : fillers)
+                if (isInSeam(filler, seamDirtyRegions[seamIdx]))
+                    resultWriter->addFiller(db->toRelative(filler), layerId);
+    return std::unique_ptr<ResultWriter>(resultWriter);
+}
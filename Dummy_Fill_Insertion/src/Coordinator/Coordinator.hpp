@@ -0,0 +1,51 @@
+#pragma once
+#include "../Parser/Parser.hpp"
+#include "../ResultWriter/ResultWriter.hpp"
+#include "../Structure/Process/Process.hpp"
+#include "../Timer/Timer.hpp"
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+// Multi-process solving on one host. The chip is cut into horizontal regions
+// that forked workers solve in parallel, each on its own rows only. Then one
+// worker per region boundary refills the rows around the boundary as an
+// incremental (ECO) problem, with the fillers of both regions kept fixed
+// outside its dirty tiles, which repairs the spacing and the density of the
+// windows crossing the boundary. Workers send their fillers back through a
+// pipe; a worker that crashes, or is still running a while past the time
+// limit, is killed and solved again by the coordinator itself.
+class Coordinator
+{
+    using LayerToFillers = std::map<int64_t, std::vector<geometry::Rectangle>>;
+
+    struct Task
+    {
+        geometry::Rectangle loadRegion, refillRegion, windowRegion;
+        LayerToFillers previousFillers;
+    };
+
+    struct Record
+    {
+        int64_t layerId, x1, y1, x2, y2;
+    };
+
+    // a worker still running at the time limit gets this long for its mandatory passes before it is taken as hung
+    static constexpr std::chrono::milliseconds minWorkerWait = std::chrono::seconds(60);
+
+    const Parser *parser;
+    const process::Database *db;
+    size_t numTileForWindow, numWorker;
+    Timer *timer;
+    int64_t tileSize;
+    size_t numTileRow;
+
+    geometry::Rectangle getRowRegion(size_t beginRowIdx, size_t endRowIdx) const;
+    LayerToFillers solveTask(const Task &task, int timeLimit) const;
+    std::vector<LayerToFillers> solveTasks(const std::vector<Task> &tasks, const std::string &name, double timeRatio);
+
+public:
+    Coordinator(const Parser *parser_, const process::Database *db_, size_t numTileForWindow_, size_t numWorker_, Timer *timer_ = nullptr);
+    ResultWriter::ptr solve();
+};
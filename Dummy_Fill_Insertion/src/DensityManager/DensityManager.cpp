@@ -1,30 +1,88 @@
 #include "DensityManager.hpp"
+#include "../MemoryTracker/MemoryReport.hpp"
+#include "../Raster/RasterWriter.hpp"
+#include "../Structure/Geometry/RectangleBatch.hpp"
+#include "../Timer/Profiler.hpp"
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <iostream>
 #include <limits>
 #include <map>
+#include <memory_resource>
+#include <queue>
 #include <set>
+#include <thread>
+#include <tuple>
 #include <unordered_map>
 #include <unordered_set>
 
-std::pair<size_t, size_t> DensityManager::getTileIdx(int64_t x, int64_t y, std::function<double(double)> func) const
+namespace sweepline
 {
-    size_t rowIdx = func(static_cast<double>(y - db->chipBoundary.y1) / tileSize);
-    size_t colIdx = func(static_cast<double>(x - db->chipBoundary.x1) / tileSize);
+    // Accessors that view a rectangle along the sweep direction of a layer, so
+    // that vertical layers are swept without transforming every rectangle.
+    using Coordinate = geometry::CompactRectangle::Coordinate;
+
+    template <process::Layer::Direction direction>
+    struct Axis;
+
+    template <>
+    struct Axis<process::Layer::Direction::HORIZONTAL>
+    {
+        static Coordinate &lower(geometry::CompactRectangle &r) { return r.x1; }
+        static Coordinate &upper(geometry::CompactRectangle &r) { return r.x2; }
+        static Coordinate &crossLower(geometry::CompactRectangle &r) { return r.y1; }
+        static Coordinate &crossUpper(geometry::CompactRectangle &r) { return r.y2; }
+        static Coordinate lower(const geometry::CompactRectangle &r) { return r.x1; }
+        static Coordinate upper(const geometry::CompactRectangle &r) { return r.x2; }
+        static Coordinate crossLower(const geometry::CompactRectangle &r) { return r.y1; }
+        static Coordinate crossUpper(const geometry::CompactRectangle &r) { return r.y2; }
+        static Coordinate length(const geometry::CompactRectangle &r) { return r.width(); }
+        static Coordinate crossLength(const geometry::CompactRectangle &r) { return r.height(); }
+        static geometry::CompactRectangle makeRectangle(Coordinate lower, Coordinate crossLower, Coordinate upper, Coordinate crossUpper)
+        {
+            return geometry::CompactRectangle(lower, crossLower, upper, crossUpper);
+        }
+    };
+
+    template <>
+    struct Axis<process::Layer::Direction::VERTICAL>
+    {
+        static Coordinate &lower(geometry::CompactRectangle &r) { return r.y1; }
+        static Coordinate &upper(geometry::CompactRectangle &r) { return r.y2; }
+        static Coordinate &crossLower(geometry::CompactRectangle &r) { return r.x1; }
+        static Coordinate &crossUpper(geometry::CompactRectangle &r) { return r.x2; }
+        static Coordinate lower(const geometry::CompactRectangle &r) { return r.y1; }
+        static Coordinate upper(const geometry::CompactRectangle &r) { return r.y2; }
+        static Coordinate crossLower(const geometry::CompactRectangle &r) { return r.x1; }
+        static Coordinate crossUpper(const geometry::CompactRectangle &r) { return r.x2; }
+        static Coordinate length(const geometry::CompactRectangle &r) { return r.height(); }
+        static Coordinate crossLength(const geometry::CompactRectangle &r) { return r.width(); }
+        static geometry::CompactRectangle makeRectangle(Coordinate lower, Coordinate crossLower, Coordinate upper, Coordinate crossUpper)
+        {
+            return geometry::CompactRectangle(crossLower, lower, crossUpper, upper);
+        }
+    };
+}
+
+std::pair<size_t, size_t> DensityManager::getTileIdx(int64_t x, int64_t y) const
+{
+    size_t rowIdx = (y - db->chipBoundary.y1) / tileSize;
+    size_t colIdx = (x - db->chipBoundary.x1) / tileSize;
     return {rowIdx, colIdx};
 }
 
-std::tuple<size_t, size_t, size_t, size_t> DensityManager::getTileIdx(const geometry::Rectangle &boundary) const
+std::tuple<size_t, size_t, size_t, size_t> DensityManager::getTileIdx(const geometry::CompactRectangle &boundary) const
 {
-    size_t beginRowIdx = std::floor(static_cast<double>(boundary.y1 - db->chipBoundary.y1) / tileSize);
-    size_t beginColIdx = std::floor(static_cast<double>(boundary.x1 - db->chipBoundary.x1) / tileSize);
-    size_t endRowIdx = std::ceil(static_cast<double>(boundary.y2 - db->chipBoundary.y1) / tileSize);
-    size_t endColIdx = std::ceil(static_cast<double>(boundary.x2 - db->chipBoundary.x1) / tileSize);
+    // boundaries are inside the chip, so the integer division is the floor
+    size_t beginRowIdx = (boundary.y1 - db->chipBoundary.y1) / tileSize;
+    size_t beginColIdx = (boundary.x1 - db->chipBoundary.x1) / tileSize;
+    size_t endRowIdx = (boundary.y2 - db->chipBoundary.y1 + tileSize - 1) / tileSize;
+    size_t endColIdx = (boundary.x2 - db->chipBoundary.x1 + tileSize - 1) / tileSize;
     return {beginRowIdx, beginColIdx, endRowIdx, endColIdx};
 }
 
-bool DensityManager::coverByOneTile(const geometry::Rectangle &boundary) const
+bool DensityManager::coverByOneTile(const geometry::CompactRectangle &boundary) const
 {
     auto [beginRowIdx, beginColIdx, endRowIdx, endColIdx] = getTileIdx(boundary);
     return (endRowIdx - beginRowIdx) == 1 && (endColIdx - beginColIdx) == 1;
@@ -46,8 +104,8 @@ void DensityManager::updateAllWindowMetalArea()
             int64_t occupyArea = 0;
             for (size_t r = 0; r < numTileForWindow; ++r)
                 for (size_t c = 0; c < numTileForWindow; ++c)
-                    occupyArea += tileGrid[rowIdx + r][colIdx + c].occupyArea();
-            windowGrid[rowIdx][colIdx] = occupyArea;
+                    occupyArea += tileGrid[windowBeginRow + rowIdx + r][windowBeginCol + colIdx + c].occupyArea();
+            windowGrid[rowIdx][colIdx].store(occupyArea);
         }
     }
 }
@@ -56,10 +114,46 @@ std::pair<int64_t, int64_t> DensityManager::getMinMaxWindowMetalArea() const
 {
     int64_t minArea = windowArea;
     int64_t maxArea = 0;
-    for (const std::vector<int64_t> &row : windowGrid)
+    for (const std::vector<process::AtomicArea> &row : windowGrid)
+    {
+        for (const process::AtomicArea &window : row)
+        {
+            int64_t area = window.load();
+            minArea = std::min(minArea, area);
+            maxArea = std::max(maxArea, area);
+        }
+    }
+    return {minArea, maxArea};
+}
+
+std::tuple<size_t, size_t, size_t, size_t> DensityManager::getWindowIdx(const process::Tile &tile) const
+{
+    // window (r, c) covers the tile rows [windowBeginRow + r, windowBeginRow + r + numTileForWindow)
+    auto [rowIdx, colIdx] = getTileIdx(tile.x1, tile.y1);
+    auto getRange = [&](size_t idx, size_t beginIdx, size_t numWindow) -> std::pair<size_t, size_t>
+    {
+        if (idx < beginIdx)
+            return {0, 0};
+        size_t offset = idx - beginIdx;
+        size_t begin = (offset + 1 > numTileForWindow) ? offset + 1 - numTileForWindow : 0;
+        size_t end = std::min(offset + 1, numWindow);
+        return {std::min(begin, end), end};
+    };
+    auto [beginWindowRow, endWindowRow] = getRange(rowIdx, windowBeginRow, numWindowRow);
+    auto [beginWindowCol, endWindowCol] = getRange(colIdx, windowBeginCol, numWindowCol);
+    return {beginWindowRow, beginWindowCol, endWindowRow, endWindowCol};
+}
+
+std::pair<int64_t, int64_t> DensityManager::getMinMaxWindowMetalArea(const process::Tile &tile) const
+{
+    int64_t minArea = windowArea;
+    int64_t maxArea = 0;
+    auto [beginWindowRow, beginWindowCol, endWindowRow, endWindowCol] = getWindowIdx(tile);
+    for (size_t rowIdx = beginWindowRow; rowIdx < endWindowRow; ++rowIdx)
     {
-        for (int64_t area : row)
+        for (size_t colIdx = beginWindowCol; colIdx < endWindowCol; ++colIdx)
         {
+            int64_t area = windowGrid[rowIdx][colIdx].load();
             minArea = std::min(minArea, area);
             maxArea = std::max(maxArea, area);
         }
@@ -67,51 +161,107 @@ std::pair<int64_t, int64_t> DensityManager::getMinMaxWindowMetalArea() const
     return {minArea, maxArea};
 }
 
+void DensityManager::addWindowMetalArea(const process::Tile &tile, int64_t area)
+{
+    auto [beginWindowRow, beginWindowCol, endWindowRow, endWindowCol] = getWindowIdx(tile);
+    for (size_t rowIdx = beginWindowRow; rowIdx < endWindowRow; ++rowIdx)
+        for (size_t colIdx = beginWindowCol; colIdx < endWindowCol; ++colIdx)
+            windowGrid[rowIdx][colIdx].add(area);
+}
+
 std::pair<double, double> DensityManager::getMinMaxWindowMetalDensity() const
 {
     auto [minArea, maxArea] = getMinMaxWindowMetalArea();
     return {static_cast<double>(minArea) / windowArea, static_cast<double>(maxArea) / windowArea};
 }
 
+int64_t DensityManager::getMaxWindowMetalArea(const geometry::CompactRectangle &boundary) const
+{
+    int64_t maxArea = 0;
+    auto [beginRowIdx, beginColIdx, endRowIdx, endColIdx] = getTileIdx(boundary);
+    for (size_t rowIdx = beginRowIdx; rowIdx < endRowIdx; ++rowIdx)
+        for (size_t colIdx = beginColIdx; colIdx < endColIdx; ++colIdx)
+            maxArea = std::max(maxArea, getMinMaxWindowMetalArea(tileGrid[rowIdx][colIdx]).second);
+    return maxArea;
+}
+
+process::Tile::Kind DensityManager::getTileKind(const process::Tile &tile) const
+{
+    if (tile.conductors.empty())
+        return process::Tile::Kind::EMPTY;
+    for (uint32_t idx : tile.conductors)
+    {
+        geometry::CompactRectangle conductor(layer->conductors[idx]);
+        if (conductor.x1 <= tile.x1 && conductor.y1 <= tile.y1 && tile.x2 <= conductor.x2 && tile.y2 <= conductor.y2)
+            return process::Tile::Kind::FULL;
+    }
+    return process::Tile::Kind::MIXED;
+}
+
 int64_t DensityManager::getConductorArea(const process::Tile &tile) const
 {
-    int64_t conductorArea = 0;
-    // directly add conductor areas
-    std::vector<std::pair<geometry::Rectangle, size_t>> regions; // (boundary, index in conductor vector)
-    for (size_t i = 0; i < tile.conductors.size(); ++i)
+    // union area by a sweep over x: between two consecutive x edges, the covered length in y is fixed
+    static thread_local std::vector<geometry::CompactRectangle> regions; // reused across tiles
+    static thread_local std::vector<int32_t> xs;
+    regions.clear();
+    xs.clear();
+    for (uint32_t idx : tile.conductors)
     {
-        geometry::Rectangle intersectRegion = geometry::getIntersectRegion(tile, *tile.conductors[i]);
-        regions.emplace_back(intersectRegion, i);
-        conductorArea += intersectRegion.area();
+        geometry::CompactRectangle intersectRegion = geometry::getIntersectRegion(tile, layer->conductors[idx]);
+        if (intersectRegion.area() == 0)
+            continue;
+        regions.emplace_back(intersectRegion);
+        xs.emplace_back(intersectRegion.x1);
+        xs.emplace_back(intersectRegion.x2);
     }
+    if (regions.size() <= 1)
+        return regions.empty() ? 0 : regions.front().area();
 
-    // handle the area of overlapping conductors
-    if (tile.conductors.size() > 1)
+    std::sort(xs.begin(), xs.end());
+    xs.erase(std::unique(xs.begin(), xs.end()), xs.end());
+    std::sort(regions.begin(), regions.end(), [](const geometry::CompactRectangle &a, const geometry::CompactRectangle &b) -> bool
+              { return a.y1 < b.y1; });
+
+    int64_t conductorArea = 0;
+    for (size_t i = 0; i + 1 < xs.size(); ++i)
     {
-        // inclusion-exclusion principle
-        int64_t sign = -1;
-        while (!regions.empty())
+        int64_t coveredLength = 0;
+        int32_t coveredY1 = 0, coveredY2 = 0; // the current run of overlapping intervals
+        for (const geometry::CompactRectangle &region : regions)
         {
-            std::vector<std::pair<geometry::Rectangle, size_t>> intersectRegions;
-            for (const auto &[region, idx] : regions)
+            if (region.x1 > xs[i] || region.x2 < xs[i + 1])
+                continue;
+            if (region.y1 > coveredY2 || coveredY1 == coveredY2)
             {
-                for (size_t i = idx + 1; i < tile.conductors.size(); ++i)
-                {
-                    geometry::Rectangle intersectRegion = geometry::getIntersectRegion(region, *tile.conductors[i]);
-                    if (intersectRegion.area() == 0)
-                        continue;
-
-                    intersectRegions.emplace_back(intersectRegion, i);
-                    conductorArea += sign * intersectRegion.area();
-                }
+                coveredLength += coveredY2 - coveredY1;
+                coveredY1 = region.y1;
+                coveredY2 = region.y2;
             }
-            sign = -sign;
-            regions.swap(intersectRegions);
-        };
+            else
+                coveredY2 = std::max(coveredY2, region.y2);
+        }
+        coveredLength += coveredY2 - coveredY1;
+        conductorArea += coveredLength * (xs[i + 1] - xs[i]);
     }
     return conductorArea;
 }
 
+bool DensityManager::isOverTime() const
+{
+    return timer && timer->overTime();
+}
+
+bool DensityManager::isOverLayerTime() const
+{
+    return timer && timer->getElapsedTime() >= layerTimeLimit;
+}
+
+Progress::Phase DensityManager::trackProgress(const std::string &pass, uint64_t numTile) const
+{
+    return Progress::Phase(pass, layer->id, numTile, [this]() -> Progress::MinMaxDensity
+                           { return getMinMaxWindowMetalDensity(); });
+}
+
 void DensityManager::initProcessLayer(process::Layer *layer_)
 {
     layer = layer_;
@@ -120,10 +270,14 @@ void DensityManager::initProcessLayer(process::Layer *layer_)
     upperRightSpacing = std::ceil(halfSpacing);
     minMetalAreaConstraint = std::ceil(windowArea * layer->minMetalDensity);
     maxMetalAreaConstraint = std::floor(windowArea * layer->maxMetalDensity);
+    numPatternLookup = 0;
+    numPatternHit = 0;
 }
 
 void DensityManager::initGrid()
 {
+    PROFILE_ZONE("initGrid");
+    Progress::Phase progress("initGrid", layer->id); // no density, the windows are reallocated
     allCandidateRegions.clear();
     allCandidateRegions.shrink_to_fit();
 
@@ -144,31 +298,36 @@ void DensityManager::initGrid()
 
     windowGrid.clear();
     windowGrid.shrink_to_fit();
-    windowGrid.resize(numWindowRow, std::vector<int64_t>(numWindowCol));
-    for (size_t rowIdx = 0; rowIdx < numWindowRow; ++rowIdx)
-        for (size_t colIdx = 0; colIdx < numWindowCol; ++colIdx)
-            for (size_t r = 0; r < numTileForWindow; ++r)
-                for (size_t c = 0; c < numTileForWindow; ++c)
-                    tileGrid[rowIdx + r][colIdx + c].windows.emplace_back(&windowGrid[rowIdx][colIdx]);
+    windowGrid.resize(numWindowRow, std::vector<process::AtomicArea>(numWindowCol));
 
     // add conductor to intersecting tiles
-    for (const process::Conductor::ptr &conductor : layer->conductors)
+    for (uint32_t idx = 0; idx < layer->conductors.size(); ++idx)
     {
-        auto [beginRowIdx, beginColIdx, endRowIdx, endColIdx] = getTileIdx(*conductor);
+        auto [beginRowIdx, beginColIdx, endRowIdx, endColIdx] = getTileIdx(layer->conductors[idx]);
         for (size_t rowIdx = beginRowIdx; rowIdx < endRowIdx; ++rowIdx)
             for (size_t colIdx = beginColIdx; colIdx < endColIdx; ++colIdx)
-                tileGrid[rowIdx][colIdx].conductors.emplace_back(conductor.get());
+                tileGrid[rowIdx][colIdx].conductors.emplace_back(idx);
     }
 
-    // calculate the total area occupied by conductors in each tile
+    // calculate the total area occupied by conductors in each tile, only a mixed tile needs the overlaps
     for (std::vector<process::Tile> &row : tileGrid)
+    {
         for (process::Tile &tile : row)
-            tile.conductorArea = getConductorArea(tile);
+        {
+            tile.kind = getTileKind(tile);
+            if (tile.kind == process::Tile::Kind::EMPTY)
+                tile.conductorArea = 0;
+            else if (tile.kind == process::Tile::Kind::FULL)
+                tile.conductorArea = tile.area();
+            else
+                tile.conductorArea = getConductorArea(tile);
+        }
+    }
 
     updateAllWindowMetalArea();
 }
 
-void DensityManager::recordFreeRegion(geometry::Rectangle *freeRegion)
+void DensityManager::recordFreeRegion(geometry::CompactRectangle *freeRegion)
 {
     auto [beginRowIdx, beginColIdx, endRowIdx, endColIdx] = getTileIdx(*freeRegion);
     for (size_t rowIdx = beginRowIdx; rowIdx < endRowIdx; ++rowIdx)
@@ -178,6 +337,9 @@ void DensityManager::recordFreeRegion(geometry::Rectangle *freeRegion)
 
 void DensityManager::insertFiller(process::Filler *filler)
 {
+    if (!filler->tryInsert())
+        return;
+    Progress::add(Progress::INSERTED_FILLERS);
     auto [beginRowIdx, beginColIdx, endRowIdx, endColIdx] = getTileIdx(*filler);
     for (size_t rowIdx = beginRowIdx; rowIdx < endRowIdx; ++rowIdx)
     {
@@ -187,15 +349,17 @@ void DensityManager::insertFiller(process::Filler *filler)
             tile.candidateFillerSet.erase(filler);
             tile.fillerSet.emplace(filler);
             int64_t area = geometry::getIntersectRegion(tile, *filler).area();
-            tile.fillerArea += area;
-            for (int64_t *window : tile.windows)
-                *window += area;
+            tile.fillerArea.add(area);
+            addWindowMetalArea(tile, area);
         }
     }
 }
 
 void DensityManager::removeFiller(process::Filler *filler)
 {
+    if (!filler->tryRemove())
+        return;
+    Progress::add(Progress::REMOVED_FILLERS);
     auto [beginRowIdx, beginColIdx, endRowIdx, endColIdx] = getTileIdx(*filler);
     for (size_t rowIdx = beginRowIdx; rowIdx < endRowIdx; ++rowIdx)
     {
@@ -205,160 +369,318 @@ void DensityManager::removeFiller(process::Filler *filler)
             tile.fillerSet.erase(filler);
             tile.candidateFillerSet.emplace(filler);
             int64_t area = geometry::getIntersectRegion(tile, *filler).area();
-            tile.fillerArea -= area;
-            for (int64_t *window : tile.windows)
-                *window -= area;
+            tile.fillerArea.add(-area);
+            addWindowMetalArea(tile, -area);
         }
     }
 }
 
-std::vector<geometry::Rectangle> DensityManager::getAllFreeRegion(size_t rowIdx, size_t colIdx) const
+bool DensityManager::isInserted(process::Filler *filler) const
+{
+    return filler->isInserted();
+}
+
+std::vector<process::Filler *> DensityManager::getAllInsertedFiller() const
 {
-    geometry::Rectangle boundary;
-    std::vector<geometry::Rectangle> conductors;
-    if (rowIdx == numTileRow && colIdx == numTileCol)
+    std::vector<process::Filler *> fillers;
+    for (const process::Filler::ptr &filler : allFillers)
+        if (isInserted(filler.get()))
+            fillers.emplace_back(filler.get());
+    return fillers;
+}
+
+bool DensityManager::isClearTile(size_t rowIdx, size_t colIdx) const
+{
+    // nothing within spacing distance, so the whole tile is one free region
+    const process::Tile &tile = tileGrid[rowIdx][colIdx];
+    if (tile.kind != process::Tile::Kind::EMPTY)
+        return false;
+
+    geometry::CompactRectangle extendBoundary(tile);
+    extendBoundary.expand(upperRightSpacing, lowerLeftSpacing);
+    size_t beginRowIdx = (rowIdx > 0) ? rowIdx - 1 : rowIdx;
+    size_t beginColIdx = (colIdx > 0) ? colIdx - 1 : colIdx;
+    size_t endRowIdx = (rowIdx + 1 < numTileRow) ? rowIdx + 1 : rowIdx;
+    size_t endColIdx = (colIdx + 1 < numTileCol) ? colIdx + 1 : colIdx;
+    for (size_t r = beginRowIdx; r <= endRowIdx; ++r)
     {
-        boundary = db->chipBoundary;
-        for (const process::Conductor::ptr &conductor : layer->conductors)
+        for (size_t c = beginColIdx; c <= endColIdx; ++c)
         {
-            geometry::Rectangle newConductor(*conductor.get());
-            newConductor.expand(lowerLeftSpacing, upperRightSpacing);
-            conductors.emplace_back(newConductor);
+            for (uint32_t idx : tileGrid[r][c].conductors)
+                if (geometry::isIntersect(extendBoundary, layer->conductors[idx]))
+                    return false;
+            for (const process::Filler *filler : tileGrid[r][c].fillerSet)
+                if (geometry::isIntersect<int32_t>(extendBoundary, *filler))
+                    return false;
         }
     }
-    else
+    return true;
+}
+
+size_t DensityManager::PatternHash::operator()(const std::vector<int32_t> &key) const
+{
+    // FNV-1a over the coordinates
+    uint64_t hash = 14695981039346656037ULL;
+    for (int32_t value : key)
+    {
+        hash ^= static_cast<uint32_t>(value);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+void DensityManager::getPatternKey(const process::Tile &tile, std::vector<geometry::CompactRectangle> &obstacles, std::vector<int32_t> &key) const
+{
+    // an expanded obstacle always reaches into the tile and the sweep never looks beyond the tile,
+    // so clipping the obstacles to the tile keeps the free regions and lets more tiles share a pattern
+    for (geometry::CompactRectangle &obstacle : obstacles)
+        obstacle = geometry::getIntersectRegion<int32_t>(obstacle, tile).shift(-tile.x1, -tile.y1);
+    std::sort(obstacles.begin(), obstacles.end(), [](const geometry::CompactRectangle &a, const geometry::CompactRectangle &b) -> bool
+              { return std::tie(a.x1, a.y1, a.x2, a.y2) < std::tie(b.x1, b.y1, b.x2, b.y2); });
+
+    key.assign({static_cast<int32_t>(layer->direction), static_cast<int32_t>(tileSize),
+                static_cast<int32_t>(layer->minFillWidth), static_cast<int32_t>(layer->maxFillWidth),
+                static_cast<int32_t>(layer->minSpacing)});
+    for (const geometry::CompactRectangle &obstacle : obstacles)
+        key.insert(key.end(), {obstacle.x1, obstacle.y1, obstacle.x2, obstacle.y2});
+}
+
+void DensityManager::getNearObstacle(size_t rowIdx, size_t colIdx, std::vector<geometry::CompactRectangle> &conductors) const
+{
+    geometry::CompactRectangle boundary(tileGrid[rowIdx][colIdx]);
+    conductors.clear();
+    size_t beginRowIdx = (rowIdx > 0) ? rowIdx - 1 : rowIdx;
+    size_t beginColIdx = (colIdx > 0) ? colIdx - 1 : colIdx;
+    size_t endRowIdx = (rowIdx + 1 < numTileRow) ? rowIdx + 1 : rowIdx;
+    size_t endColIdx = (colIdx + 1 < numTileCol) ? colIdx + 1 : colIdx;
+    geometry::CompactRectangle extendBoundary(boundary);
+    extendBoundary.expand(upperRightSpacing, lowerLeftSpacing);
+    // scratch buffers reused across tiles to keep the gather allocation-free
+    static thread_local std::vector<uint32_t> nearConductors;
+    static thread_local std::vector<process::Filler *> nearFillers, fillers;
+    static thread_local geometry::RectangleBatch nearBatch; // conductors first, then fillers
+    static thread_local std::vector<uint32_t> indices;
+    nearConductors.clear();
+    nearFillers.clear();
+    fillers.clear();
+    nearBatch.clear();
+    indices.clear();
+    for (size_t r = beginRowIdx; r <= endRowIdx; ++r)
+        for (size_t c = beginColIdx; c <= endColIdx; ++c)
+            nearConductors.insert(nearConductors.end(), tileGrid[r][c].conductors.begin(), tileGrid[r][c].conductors.end());
+    // a conductor spanning several tiles is listed in each of them
+    std::sort(nearConductors.begin(), nearConductors.end());
+    nearConductors.erase(std::unique(nearConductors.begin(), nearConductors.end()), nearConductors.end());
+    for (uint32_t idx : nearConductors)
+        nearBatch.emplace_back(layer->conductors[idx]);
+    for (size_t r = beginRowIdx; r <= endRowIdx; ++r)
     {
-        boundary = tileGrid[rowIdx][colIdx];
-        std::unordered_set<process::Conductor *> conductorSet;
-        size_t beginRowIdx = (rowIdx > 0) ? rowIdx - 1 : rowIdx;
-        size_t beginColIdx = (colIdx > 0) ? colIdx - 1 : colIdx;
-        size_t endRowIdx = (rowIdx + 1 < numTileRow) ? rowIdx + 1 : rowIdx;
-        size_t endColIdx = (colIdx + 1 < numTileCol) ? colIdx + 1 : colIdx;
-        geometry::Rectangle extendBoundary(boundary);
-        extendBoundary.expand(upperRightSpacing, lowerLeftSpacing);
-        for (size_t r = beginRowIdx; r <= endRowIdx; ++r)
-            for (size_t c = beginColIdx; c <= endColIdx; ++c)
-                for (process::Conductor *conductor : tileGrid[r][c].conductors)
-                    if (geometry::isIntersect(extendBoundary, *conductor))
-                        conductorSet.emplace(conductor);
-        for (const process::Conductor *conductor : conductorSet)
-        {
-            geometry::Rectangle newConductor(*conductor);
+        for (size_t c = beginColIdx; c <= endColIdx; ++c)
+        {
+            for (process::Filler *filler : tileGrid[r][c].fillerSet)
+            {
+                nearFillers.emplace_back(filler);
+                nearBatch.emplace_back(*filler);
+            }
+        }
+    }
+    nearBatch.selectIntersect(extendBoundary, indices);
+    for (uint32_t idx : indices)
+    {
+        if (idx < nearConductors.size())
+        {
+            geometry::CompactRectangle newConductor(nearBatch[idx]);
             newConductor.expand(lowerLeftSpacing, upperRightSpacing);
             conductors.emplace_back(newConductor);
         }
+        else
+        {
+            fillers.emplace_back(nearFillers[idx - nearConductors.size()]);
+        }
     }
-
-    if (layer->direction == process::Layer::Direction::VERTICAL)
+    // a filler spanning several tiles is listed in each of them
+    std::sort(fillers.begin(), fillers.end());
+    fillers.erase(std::unique(fillers.begin(), fillers.end()), fillers.end());
+    for (const process::Filler *filler : fillers)
     {
-        boundary.transform();
-        for (geometry::Rectangle &conductor : conductors)
-            conductor.transform();
+        geometry::CompactRectangle newFiller(*filler);
+        newFiller.expand(lowerLeftSpacing, upperRightSpacing);
+        conductors.emplace_back(newFiller);
     }
+}
+
+template <process::Layer::Direction direction>
+void DensityManager::getAllFreeRegion(size_t rowIdx, size_t colIdx, std::vector<geometry::CompactRectangle> &freeRegions) const
+{
+    static thread_local std::vector<geometry::CompactRectangle> conductors;
+    getNearObstacle(rowIdx, colIdx, conductors);
+    sweepFreeRegion<direction>(tileGrid[rowIdx][colIdx], conductors, freeRegions);
+}
 
-    std::map<int64_t, std::pair<std::vector<geometry::Rectangle *>,
-                                std::vector<geometry::Rectangle *>>>
-        conductorSweepLines; // {x, (right borders, left borders)}
-    conductorSweepLines[boundary.x1];
-    conductorSweepLines[boundary.x2];
-    for (geometry::Rectangle &conductor : conductors)
+template <process::Layer::Direction direction>
+void DensityManager::sweepFreeRegion(const geometry::CompactRectangle &boundary, const std::vector<geometry::CompactRectangle> &conductors,
+                                     std::vector<geometry::CompactRectangle> &freeRegions) const
+{
+    using Axis = sweepline::Axis<direction>;
+    using Interval = std::pair<sweepline::Coordinate, sweepline::Coordinate>;
+    constexpr uint32_t noConductor = std::numeric_limits<uint32_t>::max();
+
+    // scratch buffers reused across tiles, the sweep itself does not allocate once they are large enough
+    static thread_local std::vector<std::tuple<sweepline::Coordinate, bool, uint32_t>> borders; // {position, is lower border, conductor}
+    static thread_local std::vector<uint32_t> cutConductors;                                    // cut by the current sweep line, by cross position
+    static thread_local std::vector<Interval> freeIntervals;
+    static thread_local std::vector<geometry::CompactRectangle> tempRegions, nextTempRegions; // still open, by cross position
+    borders.clear();
+    cutConductors.clear();
+    tempRegions.clear();
+    freeRegions.clear();
+
+    // the upper borders go before the lower borders at the same position
+    borders.emplace_back(Axis::lower(boundary), false, noConductor);
+    borders.emplace_back(Axis::upper(boundary), false, noConductor);
+    for (uint32_t idx = 0; idx < conductors.size(); ++idx)
     {
-        conductorSweepLines[conductor.x1].second.emplace_back(&conductor); // left border
-        conductorSweepLines[conductor.x2].first.emplace_back(&conductor);  // rigth border
+        borders.emplace_back(Axis::lower(conductors[idx]), true, idx);
+        borders.emplace_back(Axis::upper(conductors[idx]), false, idx);
     }
-    auto cmp = [](const geometry::Rectangle *a, geometry::Rectangle *b) -> bool
+    std::sort(borders.begin(), borders.end());
+    auto cmp = [&](uint32_t a, uint32_t b) -> bool
     {
-        if (a->y1 != b->y1)
-            return a->y1 < b->y1;
-        else if (a->y2 != b->y2)
-            return a->y2 < b->y2;
-        else if (a->x1 != b->x1)
-            return a->x1 < b->x1;
-        else
-            return a->x2 < b->x2;
+        return Axis::crossLower(conductors[a]) < Axis::crossLower(conductors[b]);
     };
-    std::set<geometry::Rectangle *, decltype(cmp)> cutConductorSet(cmp); // save conductors that cut by the current sweep line
 
     int64_t minRegionWidth = 1;
-    std::vector<geometry::Rectangle> freeRegions;
-    std::unordered_set<geometry::Rectangle *> tempRegionSet;
-    for (const auto &[x, borders] : conductorSweepLines)
+    for (size_t borderIdx = 0; borderIdx < borders.size();)
     {
-        for (geometry::Rectangle *conductor : borders.first)
-            cutConductorSet.erase(conductor);
-        for (geometry::Rectangle *conductor : borders.second)
-            cutConductorSet.emplace(conductor);
+        sweepline::Coordinate pos = std::get<0>(borders[borderIdx]);
+        for (; borderIdx < borders.size() && std::get<0>(borders[borderIdx]) == pos; ++borderIdx)
+        {
+            auto [_, isLower, idx] = borders[borderIdx];
+            if (idx == noConductor)
+                continue;
+            if (isLower)
+                cutConductors.insert(std::upper_bound(cutConductors.begin(), cutConductors.end(), idx, cmp), idx);
+            else
+                cutConductors.erase(std::find(cutConductors.begin(), cutConductors.end(), idx));
+        }
 
-        if (boundary.x1 <= x && x < boundary.x2)
+        if (Axis::lower(boundary) <= pos && pos < Axis::upper(boundary))
         {
-            std::set<std::pair<int64_t, int64_t>> freeIntervalSet;
-            int64_t maxY = boundary.y1;
-            for (const geometry::Rectangle *conductor : cutConductorSet)
+            freeIntervals.clear();
+            sweepline::Coordinate maxPos = Axis::crossLower(boundary);
+            for (uint32_t idx : cutConductors)
             {
-                if (conductor->y1 - maxY >= minRegionWidth)
-                    freeIntervalSet.emplace(maxY, conductor->y1);
-                maxY = std::max(maxY, conductor->y2);
+                if (Axis::crossLower(conductors[idx]) - maxPos >= minRegionWidth)
+                    freeIntervals.emplace_back(maxPos, Axis::crossLower(conductors[idx]));
+                maxPos = std::max(maxPos, Axis::crossUpper(conductors[idx]));
             }
-            if (boundary.y2 - maxY >= minRegionWidth)
-                freeIntervalSet.emplace(maxY, boundary.y2);
+            if (Axis::crossUpper(boundary) - maxPos >= minRegionWidth)
+                freeIntervals.emplace_back(maxPos, Axis::crossUpper(boundary));
 
-            for (auto it = tempRegionSet.begin(); it != tempRegionSet.end();)
+            // both are sorted and disjoint: an open region goes on with the same interval or ends here
+            nextTempRegions.clear();
+            size_t intervalIdx = 0;
+            for (geometry::CompactRectangle &tempRegion : tempRegions)
             {
-                geometry::Rectangle *tempRegion = *it;
-                if (freeIntervalSet.count({tempRegion->y1, tempRegion->y2}))
+                Interval interval(Axis::crossLower(tempRegion), Axis::crossUpper(tempRegion));
+                for (; intervalIdx < freeIntervals.size() && freeIntervals[intervalIdx] < interval; ++intervalIdx)
+                    nextTempRegions.emplace_back(Axis::makeRectangle(pos, freeIntervals[intervalIdx].first, 0, freeIntervals[intervalIdx].second));
+                if (intervalIdx < freeIntervals.size() && freeIntervals[intervalIdx] == interval)
                 {
-                    freeIntervalSet.erase({tempRegion->y1, tempRegion->y2});
-                    ++it;
-                }
-                else
-                {
-                    tempRegion->x2 = x;
-                    if (tempRegion->width() >= minRegionWidth)
-                        freeRegions.emplace_back(*tempRegion);
-                    delete tempRegion;
-                    it = tempRegionSet.erase(it);
+                    nextTempRegions.emplace_back(tempRegion);
+                    ++intervalIdx;
+                    continue;
                 }
+                Axis::upper(tempRegion) = pos;
+                if (Axis::length(tempRegion) >= minRegionWidth)
+                    freeRegions.emplace_back(tempRegion);
             }
-            for (auto [y1, y2] : freeIntervalSet)
-                tempRegionSet.emplace(new geometry::Rectangle(x, y1, 0, y2));
+            for (; intervalIdx < freeIntervals.size(); ++intervalIdx)
+                nextTempRegions.emplace_back(Axis::makeRectangle(pos, freeIntervals[intervalIdx].first, 0, freeIntervals[intervalIdx].second));
+            tempRegions.swap(nextTempRegions);
         }
-        else if (x == boundary.x2)
+        else if (pos == Axis::upper(boundary))
         {
-            for (geometry::Rectangle *tempRegion : tempRegionSet)
+            for (geometry::CompactRectangle &tempRegion : tempRegions)
             {
-                tempRegion->x2 = x;
-                if (tempRegion->width() >= minRegionWidth)
-                    freeRegions.emplace_back(*tempRegion);
-                delete tempRegion;
+                Axis::upper(tempRegion) = pos;
+                if (Axis::length(tempRegion) >= minRegionWidth)
+                    freeRegions.emplace_back(tempRegion);
             }
             break;
         }
     }
+}
 
+void DensityManager::getAllFreeRegion(size_t rowIdx, size_t colIdx, std::vector<geometry::CompactRectangle> &freeRegions) const
+{
     if (layer->direction == process::Layer::Direction::VERTICAL)
-        for (geometry::Rectangle &freeRegion : freeRegions)
-            freeRegion.transform();
-    return freeRegions;
+        getAllFreeRegion<process::Layer::Direction::VERTICAL>(rowIdx, colIdx, freeRegions);
+    else
+        getAllFreeRegion<process::Layer::Direction::HORIZONTAL>(rowIdx, colIdx, freeRegions);
 }
 
-std::vector<geometry::Rectangle> DensityManager::refineFreeRegion(const std::vector<geometry::Rectangle> &freeRegions) const
+void DensityManager::getAllFreeRegion(const geometry::CompactRectangle &boundary, std::vector<geometry::CompactRectangle> &freeRegions) const
 {
-    int64_t minRegionWidth = layer->minFillWidth + lowerLeftSpacing + upperRightSpacing;
-    std::map<int64_t, std::pair<std::unordered_set<process::sweepline::Region *>,
-                                std::unordered_set<process::sweepline::Region *>>>
-        regionSweepLines; // {x, (right border, left border)}
+    // conductors and inserted fillers around the region, expanded by the spacing
+    geometry::CompactRectangle extendBoundary(boundary);
+    extendBoundary.expand(upperRightSpacing, lowerLeftSpacing);
+    std::vector<geometry::CompactRectangle> conductors;
+    std::vector<uint32_t> indices;
+    layer->conductors.selectIntersect(extendBoundary, indices);
+    for (uint32_t idx : indices)
+    {
+        geometry::CompactRectangle newConductor(layer->conductors[idx]);
+        newConductor.expand(lowerLeftSpacing, upperRightSpacing);
+        conductors.emplace_back(newConductor);
+    }
+    for (const process::Filler *filler : getAllInsertedFiller())
+    {
+        if (!geometry::isIntersect<int32_t>(extendBoundary, *filler))
+            continue;
+        geometry::CompactRectangle newFiller(*filler);
+        newFiller.expand(lowerLeftSpacing, upperRightSpacing);
+        conductors.emplace_back(newFiller);
+    }
+
+    if (layer->direction == process::Layer::Direction::VERTICAL)
+        sweepFreeRegion<process::Layer::Direction::VERTICAL>(boundary, conductors, freeRegions);
+    else
+        sweepFreeRegion<process::Layer::Direction::HORIZONTAL>(boundary, conductors, freeRegions);
+}
 
-    for (geometry::Rectangle freeRegion : freeRegions)
+template <process::Layer::Direction direction>
+void DensityManager::refineFreeRegion(const std::vector<geometry::CompactRectangle> &freeRegions,
+                                      std::vector<geometry::CompactRectangle> &refinedRegions) const
+{
+    using Axis = sweepline::Axis<direction>;
+    using RegionSet = std::pmr::unordered_set<process::sweepline::Region *>;
+
+    // the nodes and regions come from a per-thread pool, which keeps the memory of the previous tiles
+    static thread_local std::pmr::unsynchronized_pool_resource pool;
+    std::pmr::polymorphic_allocator<process::sweepline::Region> allocator(&pool);
+    auto newRegion = [&](const process::sweepline::Region &region) -> process::sweepline::Region *
+    {
+        process::sweepline::Region *newRegion = allocator.allocate(1);
+        new (newRegion) process::sweepline::Region(region);
+        return newRegion;
+    };
+    auto deleteRegion = [&](process::sweepline::Region *region)
     {
-        if (layer->direction == process::Layer::Direction::VERTICAL)
-            freeRegion.transform();
+        allocator.deallocate(region, 1);
+    };
+
+    int64_t minRegionWidth = layer->minFillWidth + lowerLeftSpacing + upperRightSpacing;
+    std::pmr::map<sweepline::Coordinate, std::pair<RegionSet, RegionSet>> regionSweepLines(&pool); // {position, (upper border, lower border)}
 
-        if (freeRegion.height() < minRegionWidth)
+    for (const geometry::CompactRectangle &freeRegion : freeRegions)
+    {
+        if (Axis::crossLength(freeRegion) < minRegionWidth)
             continue;
 
-        process::sweepline::Region *region = new process::sweepline::Region(freeRegion, freeRegion.width() >= minRegionWidth);
-        regionSweepLines[region->x1].second.emplace(region); // left border
-        regionSweepLines[region->x2].first.emplace(region);  // right border
+        process::sweepline::Region *region = newRegion(process::sweepline::Region(freeRegion, Axis::length(freeRegion) >= minRegionWidth));
+        regionSweepLines[Axis::lower(*region)].second.emplace(region); // lower border
+        regionSweepLines[Axis::upper(*region)].first.emplace(region);  // upper border
     }
 
     for (auto &[_, borders] : regionSweepLines)
@@ -371,47 +693,48 @@ std::vector<geometry::Rectangle> DensityManager::refineFreeRegion(const std::vec
                 process::sweepline::Region *latter = *latterIt;
                 if (former->isLegal && latter->isLegal)
                 {
-                    if (former->y1 == latter->y1 && former->y2 == latter->y2)
+                    if (Axis::crossLower(*former) == Axis::crossLower(*latter) && Axis::crossUpper(*former) == Axis::crossUpper(*latter))
                     {
-                        former->x2 = latter->x2;
-                        regionSweepLines[former->x2].first.emplace(former);
-                        regionSweepLines[latter->x1].second.erase(latter);
-                        regionSweepLines[latter->x2].first.erase(latter);
-                        delete latter;
+                        Axis::upper(*former) = Axis::upper(*latter);
+                        regionSweepLines[Axis::upper(*former)].first.emplace(former);
+                        regionSweepLines[Axis::lower(*latter)].second.erase(latter);
+                        regionSweepLines[Axis::upper(*latter)].first.erase(latter);
+                        deleteRegion(latter);
                         break;
                     }
                 }
                 else if (former->isLegal && !latter->isLegal)
                 {
-                    if (latter->y1 <= former->y1 && former->y2 <= latter->y2)
+                    if (Axis::crossLower(*latter) <= Axis::crossLower(*former) && Axis::crossUpper(*former) <= Axis::crossUpper(*latter))
                     {
-                        former->x2 = latter->x2;
-                        regionSweepLines[former->x2].first.emplace(former);
-                        if (former->y1 - latter->y1 >= minRegionWidth)
+                        Axis::upper(*former) = Axis::upper(*latter);
+                        regionSweepLines[Axis::upper(*former)].first.emplace(former);
+                        if (Axis::crossLower(*former) - Axis::crossLower(*latter) >= minRegionWidth)
                         {
-                            process::sweepline::Region *newLatter = new process::sweepline::Region(*latter);
-                            newLatter->y2 = former->y1;
-                            regionSweepLines[newLatter->x1].second.emplace(newLatter);
-                            regionSweepLines[newLatter->x2].first.emplace(newLatter);
+                            process::sweepline::Region *newLatter = newRegion(*latter);
+                            Axis::crossUpper(*newLatter) = Axis::crossLower(*former);
+                            regionSweepLines[Axis::lower(*newLatter)].second.emplace(newLatter);
+                            regionSweepLines[Axis::upper(*newLatter)].first.emplace(newLatter);
                         }
-                        if (latter->y2 - former->y2 >= minRegionWidth)
+                        if (Axis::crossUpper(*latter) - Axis::crossUpper(*former) >= minRegionWidth)
                         {
-                            latter->y1 = former->y2;
+                            Axis::crossLower(*latter) = Axis::crossUpper(*former);
                         }
                         else
                         {
-                            regionSweepLines[latter->x1].second.erase(latter);
-                            regionSweepLines[latter->x2].first.erase(latter);
+                            regionSweepLines[Axis::lower(*latter)].second.erase(latter);
+                            regionSweepLines[Axis::upper(*latter)].first.erase(latter);
+                            deleteRegion(latter);
                         }
                         break;
                     }
                 }
                 else if (!former->isLegal && latter->isLegal)
                 {
-                    if (former->y1 <= latter->y1 && latter->y2 <= former->y2)
+                    if (Axis::crossLower(*former) <= Axis::crossLower(*latter) && Axis::crossUpper(*latter) <= Axis::crossUpper(*former))
                     {
-                        latter->x1 = former->x1;
-                        regionSweepLines[latter->x1].second.emplace(latter);
+                        Axis::lower(*latter) = Axis::lower(*former);
+                        regionSweepLines[Axis::lower(*latter)].second.emplace(latter);
                         latterIt = borders.second.erase(latterIt);
                         continue;
                     }
@@ -421,39 +744,44 @@ std::vector<geometry::Rectangle> DensityManager::refineFreeRegion(const std::vec
         }
     }
 
-    std::vector<geometry::Rectangle> refinedRegions;
+    refinedRegions.clear();
     for (auto &[_, borders] : regionSweepLines)
     {
         for (process::sweepline::Region *region : borders.second)
         {
             if (region->width() >= minRegionWidth && region->height() >= minRegionWidth)
                 refinedRegions.emplace_back(*region);
-            delete region;
+            deleteRegion(region);
         }
     }
+}
 
+void DensityManager::refineFreeRegion(const std::vector<geometry::CompactRectangle> &freeRegions,
+                                      std::vector<geometry::CompactRectangle> &refinedRegions) const
+{
     if (layer->direction == process::Layer::Direction::VERTICAL)
-        for (geometry::Rectangle &refinedRegion : refinedRegions)
-            refinedRegion.transform();
-    return refinedRegions;
+        refineFreeRegion<process::Layer::Direction::VERTICAL>(freeRegions, refinedRegions);
+    else
+        refineFreeRegion<process::Layer::Direction::HORIZONTAL>(freeRegions, refinedRegions);
 }
 
-std::vector<geometry::Rectangle> DensityManager::filterIllegalRegion(const std::vector<geometry::Rectangle> &freeRegions) const
+void DensityManager::filterIllegalRegion(const std::vector<geometry::CompactRectangle> &freeRegions,
+                                         std::vector<geometry::CompactRectangle> &legalRegions) const
 {
     int64_t minRegionWidth = layer->minFillWidth + lowerLeftSpacing + upperRightSpacing;
-    std::vector<geometry::Rectangle> legalRegions;
-    for (const geometry::Rectangle &freeRegion : freeRegions)
+    legalRegions.clear();
+    for (const geometry::CompactRectangle &freeRegion : freeRegions)
     {
         if (freeRegion.width() >= minRegionWidth && freeRegion.height() >= minRegionWidth)
             legalRegions.emplace_back(freeRegion);
     }
-    return legalRegions;
 }
 
-std::vector<geometry::Rectangle> DensityManager::generateAllFiller(const std::vector<geometry::Rectangle> &freeRegions) const
+void DensityManager::generateAllFiller(const std::vector<geometry::CompactRectangle> &freeRegions,
+                                       std::vector<geometry::CompactRectangle> &fillers) const
 {
-    std::vector<geometry::Rectangle> fillers;
-    for (const geometry::Rectangle &freeRegion : freeRegions)
+    fillers.clear();
+    for (const geometry::CompactRectangle &freeRegion : freeRegions)
     {
         int64_t minRegionWidth = layer->minFillWidth + lowerLeftSpacing + upperRightSpacing;
         int64_t maxRegionWidth = layer->maxFillWidth + lowerLeftSpacing + upperRightSpacing;
@@ -473,28 +801,319 @@ std::vector<geometry::Rectangle> DensityManager::generateAllFiller(const std::ve
             {
                 int64_t x1 = freeRegion.x1 + col * width;
                 int64_t y1 = freeRegion.y1 + row * height;
-                geometry::Rectangle filler(x1, y1, x1 + width, y1 + height);
+                geometry::CompactRectangle filler(x1, y1, x1 + width, y1 + height);
                 filler.expand(-lowerLeftSpacing, -upperRightSpacing);
                 fillers.emplace_back(filler);
             }
         }
     }
-    return fillers;
+}
+
+void DensityManager::getTileFiller(size_t rowIdx, size_t colIdx, std::vector<geometry::CompactRectangle> &freeRegions,
+                                   std::vector<geometry::CompactRectangle> &fillers, KeyToPattern *missedPatterns)
+{
+    // a full tile has no free region and a clear tile is free as a whole, only the others need the sweep
+    const process::Tile &tile = tileGrid[rowIdx][colIdx];
+    freeRegions.clear();
+    fillers.clear();
+    if (tile.kind == process::Tile::Kind::FULL)
+        return;
+
+    // scratch buffers reused across tiles
+    static thread_local std::vector<geometry::CompactRectangle> obstacles, sweptRegions;
+    static thread_local std::vector<int32_t> key;
+    if (isClearTile(rowIdx, colIdx))
+    {
+        sweptRegions.assign(1, tile);
+        filterIllegalRegion(sweptRegions, freeRegions);
+        generateAllFiller(freeRegions, fillers);
+    }
+    else
+    {
+        // tiles with the same obstacles relative to their corner get the same free regions and fillers
+        getNearObstacle(rowIdx, colIdx, obstacles);
+        getPatternKey(tile, obstacles, key);
+        ++numPatternLookup;
+        auto it = patternCache.find(key);
+        if (it != patternCache.end())
+        {
+            ++numPatternHit;
+            freeRegions.assign(it->second.freeRegions.begin(), it->second.freeRegions.end());
+            fillers.assign(it->second.fillers.begin(), it->second.fillers.end());
+        }
+        else
+        {
+            geometry::CompactRectangle boundary(0, 0, tileSize, tileSize);
+            if (layer->direction == process::Layer::Direction::VERTICAL)
+                sweepFreeRegion<process::Layer::Direction::VERTICAL>(boundary, obstacles, sweptRegions);
+            else
+                sweepFreeRegion<process::Layer::Direction::HORIZONTAL>(boundary, obstacles, sweptRegions);
+            refineFreeRegion(sweptRegions, freeRegions);
+            generateAllFiller(freeRegions, fillers);
+            // the cache is only read while tiles are filled concurrently, a missed pattern is added afterwards
+            if (missedPatterns)
+                missedPatterns->emplace_back(key, Pattern{freeRegions, fillers});
+            else if (patternCache.size() < maxNumPattern)
+                patternCache.emplace(key, Pattern{freeRegions, fillers});
+        }
+        for (geometry::CompactRectangle &freeRegion : freeRegions)
+            freeRegion.shift(tile.x1, tile.y1);
+        for (geometry::CompactRectangle &filler : fillers)
+            filler.shift(tile.x1, tile.y1);
+    }
+}
+
+void DensityManager::fillTile(size_t rowIdx, size_t colIdx)
+{
+    static thread_local std::vector<geometry::CompactRectangle> freeRegions, fillers; // reused across tiles
+    getTileFiller(rowIdx, colIdx, freeRegions, fillers);
+
+    for (const geometry::CompactRectangle &freeRegion : freeRegions)
+        recordFreeRegion(&allCandidateRegions.emplace_back(freeRegion));
+
+    for (const geometry::CompactRectangle &filler : fillers)
+    {
+        process::Filler *newFiller = new process::Filler(filler, true);
+        allFillers.emplace_back(newFiller);
+        insertFiller(newFiller);
+    }
+    Progress::add(Progress::TILES);
+}
+
+std::vector<std::vector<std::pair<size_t, size_t>>> DensityManager::getTileColour(size_t period) const
+{
+    // tiles of the same colour are at least period tiles apart in a row or a column
+    std::vector<std::vector<std::pair<size_t, size_t>>> colours(period * period);
+    for (size_t rowIdx = 0; rowIdx < numTileRow; ++rowIdx)
+        for (size_t colIdx = 0; colIdx < numTileCol; ++colIdx)
+            colours[(rowIdx % period) * period + colIdx % period].emplace_back(rowIdx, colIdx);
+    return colours;
+}
+
+void DensityManager::runConcurrently(const std::vector<std::pair<size_t, size_t>> &tiles,
+                                     const std::function<void(size_t rowIdx, size_t colIdx, size_t threadIdx)> &func) const
+{
+    // each thread takes a contiguous chunk, so neighbouring tiles of a thread stay in its cache
+    size_t numUsedThread = workerPool ? workerPool->size() : 1;
+    auto run = [&](size_t threadIdx)
+    {
+        size_t beginIdx = threadIdx * tiles.size() / numUsedThread;
+        size_t endIdx = (threadIdx + 1) * tiles.size() / numUsedThread;
+        if (beginIdx == endIdx)
+            return;
+        PROFILE_ZONE("tile batch");
+        for (size_t idx = beginIdx; idx < endIdx; ++idx)
+            func(tiles[idx].first, tiles[idx].second, threadIdx);
+    };
+
+    if (workerPool)
+        workerPool->run(run);
+    else
+        run(0);
+}
+
+void DensityManager::fillAllTile()
+{
+    PROFILE_ZONE("fillAllTile");
+    Progress::Phase progress = trackProgress("fillAllTile", numTileRow * numTileCol);
+    if (numThread <= 1)
+    {
+        for (size_t rowIdx = 0; rowIdx < numTileRow; ++rowIdx)
+        {
+            PROFILE_ZONE("tile row");
+            for (size_t colIdx = 0; colIdx < numTileCol; ++colIdx)
+                fillTile(rowIdx, colIdx);
+        }
+        return;
+    }
+
+    // a tile reads the tiles next to it and writes only its own tile (in-tile fillers),
+    // so the tiles of a colour are filled at once; their windows overlap and are updated atomically
+    struct Staging
+    {
+        std::vector<process::Filler::ptr> fillers;
+        std::vector<geometry::CompactRectangle> freeRegions;
+        KeyToPattern missedPatterns;
+    };
+    std::vector<Staging> stagings(numThread);
+    for (const std::vector<std::pair<size_t, size_t>> &tiles : getTileColour(2))
+    {
+        runConcurrently(tiles, [&](size_t rowIdx, size_t colIdx, size_t threadIdx)
+                        {
+                            static thread_local std::vector<geometry::CompactRectangle> freeRegions, fillers;
+                            Staging &staging = stagings[threadIdx];
+                            getTileFiller(rowIdx, colIdx, freeRegions, fillers, &staging.missedPatterns);
+                            staging.freeRegions.insert(staging.freeRegions.end(), freeRegions.begin(), freeRegions.end());
+                            for (const geometry::CompactRectangle &filler : fillers)
+                            {
+                                process::Filler *newFiller = new process::Filler(filler, true);
+                                staging.fillers.emplace_back(newFiller);
+                                insertFiller(newFiller);
+                            }
+                            Progress::add(Progress::TILES);
+                        });
+
+        // the shared containers are updated by one thread, in thread order
+        for (Staging &staging : stagings)
+        {
+            for (const geometry::CompactRectangle &freeRegion : staging.freeRegions)
+                recordFreeRegion(&allCandidateRegions.emplace_back(freeRegion));
+            for (process::Filler::ptr &filler : staging.fillers)
+                allFillers.emplace_back(std::move(filler));
+            for (auto &[key, pattern] : staging.missedPatterns)
+                if (patternCache.size() < maxNumPattern)
+                    patternCache.emplace(std::move(key), std::move(pattern));
+            staging.fillers.clear();
+            staging.freeRegions.clear();
+            staging.missedPatterns.clear();
+        }
+    }
+}
+
+void DensityManager::fillRegion(const geometry::CompactRectangle &boundary)
+{
+    PROFILE_ZONE("fillRegion");
+    Progress::Phase progress = trackProgress("fillRegion");
+    std::vector<geometry::CompactRectangle> sweptRegions, freeRegions, fillers;
+    getAllFreeRegion(boundary, sweptRegions);
+    refineFreeRegion(sweptRegions, freeRegions);
+    for (const geometry::CompactRectangle &freeRegion : freeRegions)
+        recordFreeRegion(&allCandidateRegions.emplace_back(freeRegion));
+
+    generateAllFiller(freeRegions, fillers);
+    for (const geometry::CompactRectangle &filler : fillers)
+    {
+        process::Filler *newFiller = new process::Filler(filler, coverByOneTile(filler));
+        allFillers.emplace_back(newFiller);
+        insertFiller(newFiller);
+    }
+}
+
+std::vector<std::pair<size_t, size_t>> DensityManager::markDirtyTile()
+{
+    // tiles within spacing distance of a changed conductor are filled again
+    std::vector<std::vector<bool>> isRefill(numTileRow, std::vector<bool>(numTileCol, false));
+    for (const geometry::CompactRectangle &changedRegion : layer->changedRegions)
+    {
+        geometry::CompactRectangle boundary(changedRegion);
+        boundary.expand(layer->minSpacing, layer->minSpacing);
+        boundary = geometry::getIntersectRegion(db->chipBoundary, boundary);
+        if (!boundary.isLegal())
+            continue;
+
+        auto [beginRowIdx, beginColIdx, endRowIdx, endColIdx] = getTileIdx(boundary);
+        for (size_t rowIdx = beginRowIdx; rowIdx < endRowIdx; ++rowIdx)
+            for (size_t colIdx = beginColIdx; colIdx < endColIdx; ++colIdx)
+                isRefill[rowIdx][colIdx] = true;
+    }
+
+    // tiles of the windows overlapping a refilled tile can be changed to repair the density
+    std::vector<std::pair<size_t, size_t>> refillTiles;
+    for (std::vector<process::Tile> &row : tileGrid)
+        for (process::Tile &tile : row)
+            tile.isDirty = false;
+    for (size_t rowIdx = 0; rowIdx < numTileRow; ++rowIdx)
+    {
+        for (size_t colIdx = 0; colIdx < numTileCol; ++colIdx)
+        {
+            if (!isRefill[rowIdx][colIdx])
+                continue;
+
+            refillTiles.emplace_back(rowIdx, colIdx);
+            size_t beginRowIdx = (rowIdx + 1 > numTileForWindow) ? rowIdx + 1 - numTileForWindow : 0;
+            size_t beginColIdx = (colIdx + 1 > numTileForWindow) ? colIdx + 1 - numTileForWindow : 0;
+            size_t endRowIdx = std::min(rowIdx + numTileForWindow, numTileRow);
+            size_t endColIdx = std::min(colIdx + numTileForWindow, numTileCol);
+            for (size_t r = beginRowIdx; r < endRowIdx; ++r)
+                for (size_t c = beginColIdx; c < endColIdx; ++c)
+                    tileGrid[r][c].isDirty = true;
+        }
+    }
+    return refillTiles;
+}
+
+bool DensityManager::fillDirtyTile(bool isWholeRegion)
+{
+    PROFILE_ZONE("fillDirtyTile");
+    std::vector<std::pair<size_t, size_t>> refillTiles = markDirtyTile();
+    Progress::Phase progress = trackProgress("fillDirtyTile", isWholeRegion ? 0 : refillTiles.size());
+
+    std::vector<std::vector<bool>> isRefill(numTileRow, std::vector<bool>(numTileCol, false));
+    for (auto [rowIdx, colIdx] : refillTiles)
+        isRefill[rowIdx][colIdx] = true;
+
+    // keep the previous fillers outside the refilled tiles, only the ones outside the dirty tiles are fixed
+    for (const geometry::CompactRectangle &previousFiller : layer->previousFillers)
+    {
+        bool isInRefill = true, isOutRefill = true, isFixed = true;
+        auto [beginRowIdx, beginColIdx, endRowIdx, endColIdx] = getTileIdx(previousFiller);
+        for (size_t rowIdx = beginRowIdx; rowIdx < endRowIdx; ++rowIdx)
+        {
+            for (size_t colIdx = beginColIdx; colIdx < endColIdx; ++colIdx)
+            {
+                isInRefill = isInRefill && isRefill[rowIdx][colIdx];
+                isOutRefill = isOutRefill && !isRefill[rowIdx][colIdx];
+                isFixed = isFixed && !tileGrid[rowIdx][colIdx].isDirty;
+            }
+        }
+        // no conductor changes in a stripe, so a filler crossing the refilled tiles is still legal
+        if (db->isPartial ? isInRefill : !isOutRefill)
+            continue;
+
+        process::Filler *newFiller = new process::Filler(previousFiller, coverByOneTile(previousFiller));
+        newFiller->isFixed = isFixed;
+        allFillers.emplace_back(newFiller);
+        insertFiller(newFiller);
+    }
+
+    if (isWholeRegion && !refillTiles.empty())
+    {
+        // one fill over the bounding box of the refilled tiles
+        geometry::CompactRectangle boundary(tileGrid[refillTiles.front().first][refillTiles.front().second]);
+        for (auto [rowIdx, colIdx] : refillTiles)
+        {
+            const process::Tile &tile = tileGrid[rowIdx][colIdx];
+            boundary = geometry::CompactRectangle(std::min(boundary.x1, tile.x1), std::min(boundary.y1, tile.y1),
+                                                  std::max(boundary.x2, tile.x2), std::max(boundary.y2, tile.y2));
+        }
+        fillRegion(boundary);
+    }
+    else
+    {
+        for (auto [rowIdx, colIdx] : refillTiles)
+            fillTile(rowIdx, colIdx);
+    }
+
+    std::cout << "#refilled/dirty tiles:                " << refillTiles.size() << " ";
+    size_t numDirtyTile = 0;
+    for (const std::vector<process::Tile> &row : tileGrid)
+        for (const process::Tile &tile : row)
+            if (tile.isDirty)
+                ++numDirtyTile;
+    std::cout << numDirtyTile << "\n";
+    return getMinMaxWindowMetalArea().first >= minMetalAreaConstraint;
 }
 
 void DensityManager::removeCriticalNetFiller()
 {
+    PROFILE_ZONE("removeCriticalNetFiller");
+    Progress::Phase progress = trackProgress("removeCriticalNetFiller");
     std::unordered_set<process::Filler *> candidateRemoveSet;
-    for (const process::Conductor::ptr &criticalConductor : layer->conductors)
+    std::vector<process::Filler *> fillers;
+    geometry::RectangleBatch fillerBatch, nearBatch;
+    std::vector<uint32_t> indices;
+    std::vector<int64_t> parallelLengths, distances;
+    for (uint32_t idx = 0; idx < layer->conductors.size(); ++idx)
     {
-        if (!criticalConductor->isCritical)
+        if (!layer->conductors.isCritical(idx))
             continue;
 
-        geometry::Rectangle boundary(*criticalConductor);
+        geometry::CompactRectangle criticalConductor(layer->conductors[idx]);
+        geometry::CompactRectangle boundary(criticalConductor);
         boundary.expand(layer->minSpacing * 2, layer->minSpacing * 2);
         boundary = geometry::getIntersectRegion(db->chipBoundary, boundary);
 
-        auto [beginRowIdx, beginColIdx, endRowIdx, endColIdx] = getTileIdx(*criticalConductor);
+        auto [beginRowIdx, beginColIdx, endRowIdx, endColIdx] = getTileIdx(criticalConductor);
         beginRowIdx = (beginRowIdx > 0) ? beginRowIdx - 1 : beginRowIdx;
         beginColIdx = (beginColIdx > 0) ? beginColIdx - 1 : beginColIdx;
         endRowIdx = (endRowIdx + 1 < numTileRow) ? endRowIdx + 1 : endRowIdx;
@@ -504,14 +1123,32 @@ void DensityManager::removeCriticalNetFiller()
             for (size_t colIdx = beginColIdx; colIdx < endColIdx; ++colIdx)
             {
                 process::Tile &tile = tileGrid[rowIdx][colIdx];
+                fillers.clear();
+                fillerBatch.clear();
                 for (process::Filler *filler : tile.fillerSet)
                 {
-                    if (!geometry::isIntersect(boundary, *filler))
+                    if (filler->isFixed)
                         continue;
 
+                    fillers.emplace_back(filler);
+                    fillerBatch.emplace_back(*filler);
+                }
+
+                indices.clear();
+                fillerBatch.selectIntersect(boundary, indices);
+                if (indices.empty())
+                    continue;
+
+                nearBatch.clear();
+                for (uint32_t idx : indices)
+                    nearBatch.emplace_back(fillerBatch[idx]);
+                nearBatch.getParallelLength(criticalConductor, parallelLengths);
+                nearBatch.getDistance(criticalConductor, distances);
+                for (size_t i = 0; i < indices.size(); ++i)
+                {
+                    process::Filler *filler = fillers[indices[i]];
                     candidateRemoveSet.emplace(filler);
-                    filler->cost += static_cast<double>(geometry::getParallelLength(*criticalConductor, *filler)) /
-                                    geometry::getDistance(*criticalConductor, *filler);
+                    filler->cost += static_cast<double>(parallelLengths[i]) / distances[i];
                 }
             }
         }
@@ -522,29 +1159,83 @@ void DensityManager::removeCriticalNetFiller()
               { return a->cost > b->cost || (a->cost == b->cost && a->area() < b->area()); });
     for (process::Filler *filler : candidateRemove)
     {
+        if (isOverLayerTime())
+            break;
+
         removeFiller(filler);
         if (getMinMaxWindowMetalArea().first < minMetalAreaConstraint)
             insertFiller(filler);
     }
 }
 
+void DensityManager::removeInTileFillerConcurrently(bool isMeetDensity)
+{
+    // tiles of a colour are at least a window apart and share no window, so each one sees the windows it
+    // changes as if it ran alone; fillers crossing tiles are left to the serial pass
+    for (const std::vector<std::pair<size_t, size_t>> &tiles : getTileColour(numTileForWindow))
+    {
+        if (!isMeetDensity && isOverLayerTime())
+            return;
+
+        runConcurrently(tiles, [&](size_t rowIdx, size_t colIdx, size_t)
+                        {
+                            Progress::add(Progress::TILES);
+                            process::Tile &tile = tileGrid[rowIdx][colIdx];
+                            if (!tile.isDirty)
+                                return;
+
+                            auto [minOccupyArea, maxOccupyArea] = getMinMaxWindowMetalArea(tile);
+                            if (isMeetDensity && maxOccupyArea <= maxMetalAreaConstraint)
+                                return;
+
+                            int64_t maxRemoveArea = minOccupyArea - minMetalAreaConstraint;
+                            int64_t minRemoveArea = isMeetDensity ? maxOccupyArea - maxMetalAreaConstraint : maxRemoveArea;
+                            int64_t removeArea = 0;
+                            static thread_local std::vector<process::Filler *> fillers; // reused across tiles
+                            fillers.clear();
+                            for (process::Filler *filler : tile.fillerSet)
+                                if (filler->inTile)
+                                    fillers.emplace_back(filler);
+                            std::sort(fillers.begin(), fillers.end(), [](const process::Filler *a, const process::Filler *b) -> bool
+                                      { return a->area() < b->area(); });
+                            for (process::Filler *filler : fillers)
+                            {
+                                if (removeArea >= minRemoveArea)
+                                    break;
+                                int64_t area = filler->area();
+                                if (removeArea + area <= maxRemoveArea)
+                                {
+                                    removeFiller(filler);
+                                    removeArea += area;
+                                }
+                            }
+                        });
+    }
+}
+
 void DensityManager::meetDensityConstraint()
 {
+    PROFILE_ZONE("meetDensityConstraint");
     auto [minMetalArea, maxMatelArea] = getMinMaxWindowMetalArea();
     if (minMetalArea >= minMetalAreaConstraint && maxMatelArea <= maxMetalAreaConstraint)
         return;
+    // the concurrent pass visits every tile once more
+    Progress::Phase progress = trackProgress("meetDensityConstraint", numTileRow * numTileCol * (numThread > 1 ? 2 : 1));
+
+    // the in-tile fillers are removed concurrently first, the serial pass then handles the rest
+    if (numThread > 1)
+        removeInTileFillerConcurrently(true);
 
+    std::vector<process::Filler *> fillers; // reused across tiles
     for (std::vector<process::Tile> &row : tileGrid)
     {
         for (process::Tile &tile : row)
         {
-            int64_t minOccupyArea = windowArea;
-            int64_t maxOccupyArea = 0;
-            for (const int64_t *occupyArea : tile.windows)
-            {
-                minOccupyArea = std::min(minOccupyArea, *occupyArea);
-                maxOccupyArea = std::max(maxOccupyArea, *occupyArea);
-            }
+            Progress::add(Progress::TILES);
+            if (!tile.isDirty)
+                continue;
+
+            auto [minOccupyArea, maxOccupyArea] = getMinMaxWindowMetalArea(tile);
 
             if (maxOccupyArea <= maxMetalAreaConstraint)
                 continue;
@@ -553,7 +1244,7 @@ void DensityManager::meetDensityConstraint()
             int64_t minRemoveArea = maxOccupyArea - maxMetalAreaConstraint;
 
             int64_t removeArea = 0;
-            std::vector<process::Filler *> fillers(tile.fillerSet.begin(), tile.fillerSet.end());
+            fillers.assign(tile.fillerSet.begin(), tile.fillerSet.end());
             std::sort(fillers.begin(), fillers.end(), [](const process::Filler *a, const process::Filler *b) -> bool
                       { return a->area() < b->area(); });
             for (process::Filler *filler : fillers)
@@ -573,13 +1264,10 @@ void DensityManager::meetDensityConstraint()
                 else
                 {
                     int64_t area = geometry::getIntersectRegion(tile, *filler).area();
-                    if (removeArea + area <= maxRemoveArea)
+                    if (removeArea + area <= maxRemoveArea && getMinMaxWindowMetalArea().second > maxMetalAreaConstraint)
                     {
-                        if (getMinMaxWindowMetalArea().second > maxMetalAreaConstraint)
-                        {
-                            removeFiller(filler);
-                            removeArea += area;
-                        }
+                        removeFiller(filler);
+                        removeArea += area;
                         if (getMinMaxWindowMetalArea().first < minMetalAreaConstraint)
                         {
                             insertFiller(filler);
@@ -594,17 +1282,27 @@ void DensityManager::meetDensityConstraint()
 
 void DensityManager::removeMoreFiller()
 {
+    PROFILE_ZONE("removeMoreFiller");
+    Progress::Phase progress = trackProgress("removeMoreFiller", numTileRow * numTileCol * (numThread > 1 ? 2 : 1));
+    if (numThread > 1)
+        removeInTileFillerConcurrently(false);
+
+    std::vector<process::Filler *> fillers; // reused across tiles
     for (std::vector<process::Tile> &row : tileGrid)
     {
         for (process::Tile &tile : row)
         {
-            int64_t minOccupyArea = windowArea;
-            for (const int64_t *occupyArea : tile.windows)
-                minOccupyArea = std::min(minOccupyArea, *occupyArea);
+            if (isOverLayerTime())
+                return;
+            Progress::add(Progress::TILES);
+            if (!tile.isDirty)
+                continue;
+
+            int64_t minOccupyArea = getMinMaxWindowMetalArea(tile).first;
 
             int64_t maxRemoveArea = minOccupyArea - minMetalAreaConstraint;
             int64_t removeArea = 0;
-            std::vector<process::Filler *> fillers(tile.fillerSet.begin(), tile.fillerSet.end());
+            fillers.assign(tile.fillerSet.begin(), tile.fillerSet.end());
             std::sort(fillers.begin(), fillers.end(), [](const process::Filler *a, const process::Filler *b) -> bool
                       { return a->area() < b->area(); });
             for (process::Filler *filler : fillers)
@@ -621,13 +1319,10 @@ void DensityManager::removeMoreFiller()
                 else
                 {
                     int64_t area = geometry::getIntersectRegion(tile, *filler).area();
-                    if (removeArea + area <= maxRemoveArea)
+                    if (removeArea + area <= maxRemoveArea && getMinMaxWindowMetalArea().second > maxMetalAreaConstraint)
                     {
-                        if (getMinMaxWindowMetalArea().second > maxMetalAreaConstraint)
-                        {
-                            removeFiller(filler);
-                            removeArea += area;
-                        }
+                        removeFiller(filler);
+                        removeArea += area;
                         if (getMinMaxWindowMetalArea().first < minMetalAreaConstraint)
                         {
                             insertFiller(filler);
@@ -640,15 +1335,221 @@ void DensityManager::removeMoreFiller()
     }
 }
 
+int64_t DensityManager::getDeficitRelief(process::Filler *filler) const
+{
+    int64_t relief = 0;
+    auto [beginRowIdx, beginColIdx, endRowIdx, endColIdx] = getTileIdx(*filler);
+    for (size_t rowIdx = beginRowIdx; rowIdx < endRowIdx; ++rowIdx)
+    {
+        for (size_t colIdx = beginColIdx; colIdx < endColIdx; ++colIdx)
+        {
+            const process::Tile &tile = tileGrid[rowIdx][colIdx];
+            int64_t area = geometry::getIntersectRegion(tile, *filler).area();
+            auto [beginWindowRow, beginWindowCol, endWindowRow, endWindowCol] = getWindowIdx(tile);
+            for (size_t windowRowIdx = beginWindowRow; windowRowIdx < endWindowRow; ++windowRowIdx)
+            {
+                for (size_t windowColIdx = beginWindowCol; windowColIdx < endWindowCol; ++windowColIdx)
+                {
+                    int64_t windowOccupyArea = windowGrid[windowRowIdx][windowColIdx].load();
+                    if (windowOccupyArea < minMetalAreaConstraint)
+                        relief += std::min(area, minMetalAreaConstraint - windowOccupyArea);
+                }
+            }
+        }
+    }
+    return relief;
+}
+
+void DensityManager::insertBackFiller()
+{
+    PROFILE_ZONE("insertBackFiller");
+    Progress::Phase progress = trackProgress("insertBackFiller");
+    if (getMinMaxWindowMetalArea().first >= minMetalAreaConstraint)
+        return;
+
+    std::unordered_set<process::Filler *> candidateSet;
+    for (const std::vector<process::Tile> &row : tileGrid)
+        for (const process::Tile &tile : row)
+            candidateSet.insert(tile.candidateFillerSet.begin(), tile.candidateFillerSet.end());
+
+    // (filler, deficit relief), lowest cost first and then highest relief
+    using Candidate = std::pair<process::Filler *, int64_t>;
+    auto cmp = [](const Candidate &a, const Candidate &b) -> bool
+    { return a.first->cost > b.first->cost || (a.first->cost == b.first->cost && a.second < b.second); };
+    std::priority_queue<Candidate, std::vector<Candidate>, decltype(cmp)> candidateQueue(cmp);
+    for (process::Filler *filler : candidateSet)
+    {
+        int64_t relief = getDeficitRelief(filler);
+        if (relief > 0)
+            candidateQueue.emplace(filler, relief);
+    }
+
+    while (!candidateQueue.empty())
+    {
+        auto [filler, relief] = candidateQueue.top();
+        candidateQueue.pop();
+
+        // the relief shrinks as other fillers are inserted back, so re-check it lazily
+        int64_t curRelief = getDeficitRelief(filler);
+        if (curRelief == 0)
+            continue;
+        if (curRelief < relief)
+        {
+            candidateQueue.emplace(filler, curRelief);
+            continue;
+        }
+
+        insertFiller(filler);
+        if (getMaxWindowMetalArea(*filler) > maxMetalAreaConstraint)
+        {
+            removeFiller(filler);
+            continue;
+        }
+        if (getMinMaxWindowMetalArea().first >= minMetalAreaConstraint)
+            break;
+    }
+}
+
+bool DensityManager::isFreeGap(const geometry::CompactRectangle &gap, const process::Filler *former, const process::Filler *latter) const
+{
+    geometry::CompactRectangle spacingBoundary(gap);
+    spacingBoundary.expand(layer->minSpacing, layer->minSpacing);
+    geometry::CompactRectangle criticalBoundary(gap);
+    criticalBoundary.expand(layer->minSpacing * 2, layer->minSpacing * 2);
+
+    auto [beginRowIdx, beginColIdx, endRowIdx, endColIdx] = getTileIdx(geometry::getIntersectRegion(db->chipBoundary, criticalBoundary));
+    for (size_t rowIdx = beginRowIdx; rowIdx < endRowIdx; ++rowIdx)
+    {
+        for (size_t colIdx = beginColIdx; colIdx < endColIdx; ++colIdx)
+        {
+            const process::Tile &tile = tileGrid[rowIdx][colIdx];
+            for (uint32_t idx : tile.conductors)
+                if (geometry::isIntersect(layer->conductors.isCritical(idx) ? criticalBoundary : spacingBoundary, layer->conductors[idx]))
+                    return false;
+            for (const process::Filler *filler : tile.fillerSet)
+                if (filler != former && filler != latter && geometry::isIntersect(spacingBoundary, *filler))
+                    return false;
+        }
+    }
+    return true;
+}
+
+bool DensityManager::mergeFiller(process::Filler *former, process::Filler *latter, bool isHorizontal)
+{
+    if (former->isFixed || latter->isFixed || former->cost > 0 || latter->cost > 0)
+        return false;
+
+    geometry::CompactRectangle gap;
+    if (isHorizontal)
+    {
+        if (former->y1 != latter->y1 || former->y2 != latter->y2 || latter->x2 - former->x1 > layer->maxFillWidth)
+            return false;
+        gap = geometry::CompactRectangle(former->x2, former->y1, latter->x1, former->y2);
+    }
+    else
+    {
+        if (former->x1 != latter->x1 || former->x2 != latter->x2 || latter->y2 - former->y1 > layer->maxFillWidth)
+            return false;
+        gap = geometry::CompactRectangle(former->x1, former->y2, former->x2, latter->y1);
+    }
+    if (!gap.isLegal() || !isFreeGap(gap, former, latter))
+        return false;
+
+    geometry::CompactRectangle formerBoundary(*former);
+    removeFiller(former);
+    removeFiller(latter);
+    if (isHorizontal)
+        former->x2 = latter->x2;
+    else
+        former->y2 = latter->y2;
+    insertFiller(former);
+
+    if (getMaxWindowMetalArea(*former) > maxMetalAreaConstraint)
+    {
+        removeFiller(former);
+        former->x2 = formerBoundary.x2;
+        former->y2 = formerBoundary.y2;
+        insertFiller(former);
+        insertFiller(latter);
+        return false;
+    }
+
+    // the merged filler is no longer a candidate to be inserted back
+    auto [beginRowIdx, beginColIdx, endRowIdx, endColIdx] = getTileIdx(*latter);
+    for (size_t rowIdx = beginRowIdx; rowIdx < endRowIdx; ++rowIdx)
+        for (size_t colIdx = beginColIdx; colIdx < endColIdx; ++colIdx)
+            tileGrid[rowIdx][colIdx].candidateFillerSet.erase(latter);
+    former->inTile = coverByOneTile(*former);
+    return true;
+}
+
+void DensityManager::mergeAllFiller()
+{
+    PROFILE_ZONE("mergeAllFiller");
+    Progress::Phase progress = trackProgress("mergeAllFiller");
+    std::vector<process::Filler *> fillers = getAllInsertedFiller();
+
+    // merge row by row
+    std::sort(fillers.begin(), fillers.end(), [](const process::Filler *a, const process::Filler *b) -> bool
+              { return std::make_tuple(a->y1, a->y2, a->x1) < std::make_tuple(b->y1, b->y2, b->x1); });
+    std::vector<process::Filler *> remainFillers;
+    for (process::Filler *filler : fillers)
+        if (isOverLayerTime() || remainFillers.empty() || !mergeFiller(remainFillers.back(), filler, true))
+            remainFillers.emplace_back(filler);
+
+    // merge column by column
+    fillers.swap(remainFillers);
+    remainFillers.clear();
+    std::sort(fillers.begin(), fillers.end(), [](const process::Filler *a, const process::Filler *b) -> bool
+              { return std::make_tuple(a->x1, a->x2, a->y1) < std::make_tuple(b->x1, b->x2, b->y1); });
+    for (process::Filler *filler : fillers)
+        if (isOverLayerTime() || remainFillers.empty() || !mergeFiller(remainFillers.back(), filler, false))
+            remainFillers.emplace_back(filler);
+}
+
+void DensityManager::writeRaster(const std::vector<process::Filler *> &fillers) const
+{
+    PROFILE_ZONE("writeRaster");
+    Progress::Phase progress = trackProgress("writeRaster");
+    int64_t resolution = rasterResolution > 0 ? rasterResolution : RasterWriter::getAutoResolution(db->chipBoundary);
+    std::string filePrefix = rasterPrefix + "." + std::to_string(layer->id);
+
+    std::vector<std::vector<double>> densities(numWindowRow, std::vector<double>(numWindowCol));
+    for (size_t rowIdx = 0; rowIdx < numWindowRow; ++rowIdx)
+        for (size_t colIdx = 0; colIdx < numWindowCol; ++colIdx)
+            densities[rowIdx][colIdx] = static_cast<double>(windowGrid[rowIdx][colIdx].load()) / windowArea;
+    // a window position steps by one tile, so the heatmap has about the scale of the coverage images
+    bool isWritten = RasterWriter::writeDensityHeatmap(filePrefix + ".density.ppm", densities, layer->minMetalDensity,
+                                                       layer->maxMetalDensity, std::max<int64_t>(tileSize / resolution, 1));
+
+    if (isRasterCoverage)
+    {
+        // the images are written after the solver threads are done, so all the cores are used regardless of numThread
+        RasterWriter rasterWriter(db->chipBoundary, resolution, std::max(std::thread::hardware_concurrency(), 1u));
+        std::vector<geometry::CompactRectangle> rectangles;
+        rectangles.reserve(layer->conductors.size());
+        for (size_t idx = 0; idx < layer->conductors.size(); ++idx)
+            rectangles.emplace_back(layer->conductors[idx]);
+        isWritten = rasterWriter.writeCoverage(filePrefix + ".conductor.pgm", rectangles) && isWritten;
+        rectangles.clear();
+        for (const process::Filler *filler : fillers)
+            rectangles.emplace_back(*filler);
+        isWritten = rasterWriter.writeCoverage(filePrefix + ".filler.pgm", rectangles) && isWritten;
+    }
+    if (isWritten)
+        std::cout << "Raster (units per pixel):             " << filePrefix << ".* (" << resolution << ")\n";
+}
+
 int64_t DensityManager::getOccupyAreaBruteForce(const process::Tile &tile) const
 {
     std::vector<std::vector<bool>> detailGird(tileSize, std::vector<bool>(tileSize, false));
-    for (const process::Conductor::ptr &conductor : layer->conductors)
+    for (size_t i = 0; i < layer->conductors.size(); ++i)
     {
-        if (!geometry::isIntersect(tile, *conductor))
+        geometry::CompactRectangle conductor(layer->conductors[i]);
+        if (!geometry::isIntersect(tile, conductor))
             continue;
 
-        geometry::Rectangle region = geometry::getIntersectRegion(tile, *conductor);
+        geometry::CompactRectangle region = geometry::getIntersectRegion(tile, conductor);
         region.shift(-tile.x1, -tile.y1);
         for (int64_t y = region.y1; y < region.y2; ++y)
             for (int64_t x = region.x1; x < region.x2; ++x)
@@ -666,7 +1567,7 @@ int64_t DensityManager::getOccupyAreaBruteForce(const process::Tile &tile) const
         if (!geometry::isIntersect(tile, *filler))
             continue;
 
-        geometry::Rectangle region = geometry::getIntersectRegion(tile, *filler);
+        geometry::CompactRectangle region = geometry::getIntersectRegion(tile, *filler);
         region.shift(-tile.x1, -tile.y1);
         for (int64_t y = region.y1; y < region.y2; ++y)
             for (int64_t x = region.x1; x < region.x2; ++x)
@@ -681,10 +1582,10 @@ int64_t DensityManager::getOccupyAreaBruteForce(const process::Tile &tile) const
     return area;
 }
 
-void DensityManager::drawBorder(std::vector<std::vector<char>> &detailGrid, const geometry::Rectangle &boundary,
-                                const geometry::Rectangle &region, double scaling, char h, char v) const
+void DensityManager::drawBorder(std::vector<std::vector<char>> &detailGrid, const geometry::CompactRectangle &boundary,
+                                const geometry::CompactRectangle &region, double scaling, char h, char v) const
 {
-    geometry::Rectangle rectangle(region);
+    geometry::CompactRectangle rectangle(region);
     rectangle.shift(-boundary.x1, -boundary.y1).scale(scaling);
 
     if (!rectangle.isLegal())
@@ -696,10 +1597,10 @@ void DensityManager::drawBorder(std::vector<std::vector<char>> &detailGrid, cons
         detailGrid[rectangle.y1][x] = detailGrid[rectangle.y2 - 1][x] = h;
 }
 
-void DensityManager::drawRegion(std::vector<std::vector<char>> &detailGrid, const geometry::Rectangle &boundary,
-                                const geometry::Rectangle &region, double scaling, char c) const
+void DensityManager::drawRegion(std::vector<std::vector<char>> &detailGrid, const geometry::CompactRectangle &boundary,
+                                const geometry::CompactRectangle &region, double scaling, char c) const
 {
-    geometry::Rectangle rectangle(region);
+    geometry::CompactRectangle rectangle(region);
     rectangle.shift(-boundary.x1, -boundary.y1).scale(scaling);
 
     if (!rectangle.isLegal())
@@ -718,11 +1619,11 @@ void DensityManager::drawTile(std::ostream &output, size_t rowIdx, size_t colIdx
                                               std::vector<char>(tile.width() * scaling, ' '));
     drawBorder(detailGrid, tile, tile, scaling);
 
-    for (const process::Conductor *conductor : tile.conductors)
-        if (!conductor->isCritical)
-            drawBorder(detailGrid, tile, geometry::getIntersectRegion(tile, *conductor), scaling, '.', '.');
+    for (uint32_t idx : tile.conductors)
+        if (!layer->conductors.isCritical(idx))
+            drawBorder(detailGrid, tile, geometry::getIntersectRegion(tile, layer->conductors[idx]), scaling, '.', '.');
         else
-            drawRegion(detailGrid, tile, geometry::getIntersectRegion(tile, *conductor), scaling, '.');
+            drawRegion(detailGrid, tile, geometry::getIntersectRegion(tile, layer->conductors[idx]), scaling, '.');
 
     if (drawFiller)
     {
@@ -731,7 +1632,7 @@ void DensityManager::drawTile(std::ostream &output, size_t rowIdx, size_t colIdx
     }
     else
     {
-        for (const geometry::Rectangle *candidateRegion : tile.candidateRegions)
+        for (const geometry::CompactRectangle *candidateRegion : tile.candidateRegions)
             drawBorder(detailGrid, tile, geometry::getIntersectRegion(tile, *candidateRegion), scaling, '#', '#');
     }
 
@@ -754,27 +1655,27 @@ void DensityManager::drawTile(std::ostream &output, size_t rowIdx, size_t colIdx
 void DensityManager::drawWindow(std::ostream &output, size_t rowIdx, size_t colIdx, bool drawFiller, double scaling) const
 {
     assert(rowIdx < numWindowRow && colIdx < numWindowCol);
-    const auto &[windowX, windowY] = getTilePos(rowIdx, colIdx);
-    geometry::Rectangle window(windowX, windowY, windowX + db->windowSize, windowY + db->windowSize);
+    const auto &[windowX, windowY] = getTilePos(windowBeginRow + rowIdx, windowBeginCol + colIdx);
+    geometry::CompactRectangle window(windowX, windowY, windowX + db->windowSize, windowY + db->windowSize);
     std::vector<std::vector<char>> detailGrid(window.height() * scaling,
                                               std::vector<char>(window.width() * scaling, ' '));
 
     drawBorder(detailGrid, window, window, scaling);
 
-    std::unordered_set<process::Conductor *> conductors;
-    std::unordered_set<geometry::Rectangle *> fillers, candidateRegions;
+    std::unordered_set<uint32_t> conductors;
+    std::unordered_set<geometry::CompactRectangle *> fillers, candidateRegions;
     for (size_t r = 0; r < numTileForWindow; ++r)
     {
         for (size_t c = 0; c < numTileForWindow; ++c)
         {
-            const process::Tile &tile = tileGrid[rowIdx + r][colIdx + c];
-            for (process::Conductor *conductor : tile.conductors)
+            const process::Tile &tile = tileGrid[windowBeginRow + rowIdx + r][windowBeginCol + colIdx + c];
+            for (uint32_t idx : tile.conductors)
             {
-                conductors.emplace(conductor);
-                if (!conductor->isCritical)
-                    drawBorder(detailGrid, window, geometry::getIntersectRegion(window, *conductor), scaling, '.', '.');
+                conductors.emplace(idx);
+                if (!layer->conductors.isCritical(idx))
+                    drawBorder(detailGrid, window, geometry::getIntersectRegion(window, layer->conductors[idx]), scaling, '.', '.');
                 else
-                    drawRegion(detailGrid, window, geometry::getIntersectRegion(window, *conductor), scaling, '.');
+                    drawRegion(detailGrid, window, geometry::getIntersectRegion(window, layer->conductors[idx]), scaling, '.');
             }
             if (drawFiller)
             {
@@ -786,7 +1687,7 @@ void DensityManager::drawWindow(std::ostream &output, size_t rowIdx, size_t colI
             }
             else
             {
-                for (geometry::Rectangle *candidateRegion : tile.candidateRegions)
+                for (geometry::CompactRectangle *candidateRegion : tile.candidateRegions)
                 {
                     candidateRegions.emplace(candidateRegion);
                     drawBorder(detailGrid, window, geometry::getIntersectRegion(window, *candidateRegion), scaling, '#', '#');
@@ -798,7 +1699,7 @@ void DensityManager::drawWindow(std::ostream &output, size_t rowIdx, size_t colI
 
     output << "Layer id:             " << layer->id << "\n"
            << "Window row/col index: " << rowIdx << " " << colIdx << "\n"
-           << "Density:              " << static_cast<double>(windowGrid[rowIdx][colIdx]) / windowArea << "\n"
+           << "Density:              " << static_cast<double>(windowGrid[rowIdx][colIdx].load()) / windowArea << "\n"
            << "#conductors:          " << conductors.size() << "\n";
     if (drawFiller)
         output << "#fillers:             " << fillers.size() << "\n";
@@ -812,106 +1713,261 @@ void DensityManager::drawWindow(std::ostream &output, size_t rowIdx, size_t colI
     }
 }
 
-DensityManager::DensityManager(process::Database *db_, size_t numTileForWindow_)
-    : db(db_), numTileForWindow(numTileForWindow_),
+bool DensityManager::isValidNumTileForWindow(int64_t windowSize, size_t numTileForWindow)
+{
+    return numTileForWindow > 0 && numTileForWindow % numStepForWindow == 0 &&
+           windowSize % numTileForWindow == 0;
+}
+
+size_t DensityManager::getAutoNumTileForWindow(const process::Database *db)
+{
+    // estimate the relative solving cost of each candidate from sampled conductor sizes:
+    // per tile overhead + sweep line over the neighbouring conductors + window updates of the fillers
+    const size_t maxNumSample = 1024;
+    const double tileOverhead = 64;
+    double chipArea = static_cast<double>(db->chipBoundary.width()) * db->chipBoundary.height();
+
+    size_t bestNumTileForWindow = numStepForWindow;
+    double minCost = std::numeric_limits<double>::max();
+    std::cout << "----- TILE SUBDIVISION -----\n";
+    for (size_t numTileForWindow = numStepForWindow; numTileForWindow <= numStepForWindow * 4; numTileForWindow += numStepForWindow)
+    {
+        if (!isValidNumTileForWindow(db->windowSize, numTileForWindow))
+            continue;
+
+        double tileSize = static_cast<double>(db->windowSize / numTileForWindow);
+        double numTile = std::floor(db->chipBoundary.width() / tileSize) * std::floor(db->chipBoundary.height() / tileSize);
+        double cost = 0;
+        for (const process::Layer::ptr &layer : db->layers)
+        {
+            if (layer->conductors.empty())
+            {
+                cost += numTile * tileOverhead;
+                continue;
+            }
+
+            double avgWidth = 0, avgHeight = 0;
+            size_t step = std::max(layer->conductors.size() / maxNumSample, static_cast<size_t>(1));
+            size_t numSample = 0;
+            for (size_t i = 0; i < layer->conductors.size(); i += step, ++numSample)
+            {
+                avgWidth += layer->conductors[i].width();
+                avgHeight += layer->conductors[i].height();
+            }
+            avgWidth /= numSample;
+            avgHeight /= numSample;
+
+            double numNeighbor = layer->conductors.size() * (3 * tileSize + avgWidth) * (3 * tileSize + avgHeight) / chipArea;
+            double fillerPitch = layer->maxFillWidth + layer->minSpacing;
+            double numFiller = std::max(tileSize * tileSize / (fillerPitch * fillerPitch), 1.0);
+            cost += numTile * (tileOverhead + numNeighbor * std::log2(numNeighbor + 2) +
+                               numFiller * numTileForWindow * numTileForWindow);
+        }
+
+        printf("Estimated cost (#tiles per window side = %zu): %.4e\n", numTileForWindow, cost);
+        if (cost < minCost)
+        {
+            minCost = cost;
+            bestNumTileForWindow = numTileForWindow;
+        }
+    }
+    std::cout << "#tiles per window side: " << bestNumTileForWindow << "\n"
+              << "\n";
+    return bestNumTileForWindow;
+}
+
+DensityManager::DensityManager(process::Database *db_, size_t numTileForWindow_, Timer *timer_, size_t numThread_)
+    : db(db_), numTileForWindow(numTileForWindow_), numThread(std::max<size_t>(numThread_, 1)), timer(timer_), layerTimeLimit(0), mandatoryTime(0),
+      rasterResolution(0), isRasterCoverage(false),
       tileSize(db->windowSize / numTileForWindow),
       tileArea(tileSize * tileSize),
       windowArea(db->windowSize * db->windowSize),
       numTileRow(db->chipBoundary.height() / tileSize),
       numTileCol(db->chipBoundary.width() / tileSize),
-      numWindowRow(numTileRow - numTileForWindow + 1),
-      numWindowCol(numTileCol - numTileForWindow + 1)
+      windowBeginRow((db->windowBoundary.y1 - db->chipBoundary.y1) / tileSize),
+      windowBeginCol((db->windowBoundary.x1 - db->chipBoundary.x1) / tileSize),
+      numWindowRow(db->windowBoundary.height() / tileSize - numTileForWindow + 1),
+      numWindowCol(db->windowBoundary.width() / tileSize - numTileForWindow + 1),
+      numPatternLookup(0), numPatternHit(0)
 {
+    if (numThread > 1)
+        workerPool.reset(new WorkerPool(numThread));
     std::cout << "----- TILE GRID INFORMATION -----\n"
               << "Window size:     " << db->windowSize << "\n"
               << "Tile size:       " << tileSize << "\n"
               << "#tile row/col:   " << numTileRow << " " << numTileCol << "\n"
               << "#window row/col: " << numWindowRow << " " << numWindowCol << "\n"
+              << "#threads:        " << numThread << "\n"
               << "\n";
 }
 
+DensityManager::~DensityManager()
+{
+    MemoryReport::release("DensityManager");
+}
+
+void DensityManager::setRaster(const std::string &filePrefix, int64_t resolution, bool isCoverage)
+{
+    rasterPrefix = filePrefix;
+    rasterResolution = resolution;
+    isRasterCoverage = isCoverage;
+}
+
+void DensityManager::recordMemory(const std::string &phase, const ResultWriter *resultWriter) const
+{
+    size_t numTile = 0, numTileByte = MemoryReport::getNumByte(tileGrid);
+    size_t numConductorRef = 0, numConductorRefByte = 0;
+    size_t numRegionRef = 0, numRegionRefByte = 0, numCandidateRef = 0, numCandidateRefByte = 0, numFillerRef = 0, numFillerRefByte = 0;
+    for (const std::vector<process::Tile> &row : tileGrid)
+    {
+        numTile += row.size();
+        numTileByte += MemoryReport::getNumByte(row);
+        for (const process::Tile &tile : row)
+        {
+            numConductorRef += tile.conductors.size();
+            numConductorRefByte += MemoryReport::getNumByte(tile.conductors);
+            numRegionRef += tile.candidateRegions.size();
+            numRegionRefByte += MemoryReport::getNumByte(tile.candidateRegions);
+            numCandidateRef += tile.candidateFillerSet.size();
+            numCandidateRefByte += MemoryReport::getNumByte(tile.candidateFillerSet);
+            numFillerRef += tile.fillerSet.size();
+            numFillerRefByte += MemoryReport::getNumByte(tile.fillerSet);
+        }
+    }
+    size_t numWindow = 0, numWindowByte = MemoryReport::getNumByte(windowGrid);
+    for (const std::vector<process::AtomicArea> &row : windowGrid)
+    {
+        numWindow += row.size();
+        numWindowByte += MemoryReport::getNumByte(row);
+    }
+    // a hash map node holds the key, the pattern, the cached hash and the next pointer
+    size_t numPatternByte = patternCache.bucket_count() * sizeof(void *);
+    for (const auto &[key, pattern] : patternCache)
+        numPatternByte += sizeof(key) + sizeof(pattern) + 2 * sizeof(void *) + MemoryReport::getNumByte(key) +
+                          MemoryReport::getNumByte(pattern.freeRegions) + MemoryReport::getNumByte(pattern.fillers);
+
+    MemoryReport::record("DensityManager", "tileGrid", numTile, numTileByte);
+    MemoryReport::record("DensityManager", "tile conductors", numConductorRef, numConductorRefByte);
+    MemoryReport::record("DensityManager", "tile candidateRegions", numRegionRef, numRegionRefByte);
+    MemoryReport::record("DensityManager", "tile candidateFillerSet", numCandidateRef, numCandidateRefByte);
+    MemoryReport::record("DensityManager", "tile fillerSet", numFillerRef, numFillerRefByte);
+    MemoryReport::record("DensityManager", "windowGrid", numWindow, numWindowByte);
+    MemoryReport::record("DensityManager", "allCandidateRegions", allCandidateRegions.size(), MemoryReport::getNumByte(allCandidateRegions));
+    MemoryReport::record("DensityManager", "allFillers", allFillers.size(), MemoryReport::getNumByte(allFillers));
+    MemoryReport::record("DensityManager", "patternCache", patternCache.size(), numPatternByte);
+    resultWriter->recordMemory();
+
+    const MemoryReport::Snapshot &snapshot = MemoryReport::takeSnapshot(phase, layer->id);
+    printf("Memory (tracked/RSS/peak RSS, MB):    %.2lf %.2lf %.2lf\n", snapshot.getNumByte() / 1048576.0,
+           snapshot.currentMemory / 1024.0, snapshot.peakMemory / 1024.0);
+}
+
 ResultWriter::ptr DensityManager::solve()
 {
-    ResultWriter *resultWriter = new ResultWriter();
-    for (const process::Layer::ptr &curLayer : db->layers)
+    ResultWriter *resultWriter = new ResultWriter(db->originX, db->originY);
+    for (size_t layerIdx = 0; layerIdx < db->layers.size(); ++layerIdx)
     {
-        initProcessLayer(curLayer.get());
+        PROFILE_ZONE("layer", db->layers[layerIdx]->id);
+        Progress::Phase progress("solve layer", db->layers[layerIdx]->id); // between the passes
+        // reserve time for the mandatory passes of the later layers and share the rest equally
+        std::chrono::milliseconds layerStartTime(0), layerMandatoryTime(0);
+        if (timer)
+        {
+            size_t numRemainLayer = db->layers.size() - layerIdx;
+            std::chrono::milliseconds remainingTime = timer->getRemainingTime() - mandatoryTime * (numRemainLayer - 1);
+            layerStartTime = timer->getElapsedTime();
+            layerTimeLimit = layerStartTime + std::max(remainingTime, std::chrono::milliseconds(0)) / numRemainLayer;
+        }
+
+        initProcessLayer(db->layers[layerIdx].get());
         std::cout << "----- LAYER " << layer->id << " -----\n"
                   << "Layer Direction:                      " << layer->directionName() << "\n";
         printf("Min/Max density constraint:           %.4lf %.4lf\n", layer->minMetalDensity, layer->maxMetalDensity);
 
         initGrid();
+        size_t numTileOfKind[3] = {0, 0, 0};
+        for (const std::vector<process::Tile> &row : tileGrid)
+            for (const process::Tile &tile : row)
+                ++numTileOfKind[static_cast<size_t>(tile.kind)];
+        std::cout << "#empty/full/mixed tiles:              " << numTileOfKind[0] << " " << numTileOfKind[1] << " " << numTileOfKind[2] << "\n";
         std::pair<double, double> minMaxDensity = getMinMaxWindowMetalDensity();
         printf("Min/Max density (original):           %.4lf %.4lf\n", minMaxDensity.first, minMaxDensity.second);
+        recordMemory("original", resultWriter);
 
-        for (size_t rowIdx = 0; rowIdx < numTileRow; ++rowIdx)
+        // a stripe cannot be re-solved as a whole, the fallback below refills its rows at once instead
+        bool isIncremental = db->isIncremental && (fillDirtyTile() || db->isPartial);
+        if (db->isIncremental && !isIncremental)
         {
-            for (size_t colIdx = 0; colIdx < numTileCol; ++colIdx)
-            {
-                std::vector<geometry::Rectangle> freeRegions = getAllFreeRegion(rowIdx, colIdx);
-                freeRegions = refineFreeRegion(freeRegions);
-                for (const geometry::Rectangle &freeRegion : freeRegions)
-                {
-                    geometry::Rectangle *newFreeRegion = new geometry::Rectangle(freeRegion);
-                    allCandidateRegions.emplace_back(newFreeRegion);
-                    recordFreeRegion(newFreeRegion);
-                }
-
-                std::vector<geometry::Rectangle> fillers = generateAllFiller(freeRegions);
-                for (const geometry::Rectangle &filler : fillers)
-                {
-                    process::Filler *newFiller = new process::Filler(filler, true);
-                    allFillers.emplace_back(newFiller);
-                    insertFiller(newFiller);
-                }
-            }
+            std::cout << "[Warning] Cannot meet the density constraint incrementally. Re-solve the whole layer.\n";
+            initGrid();
         }
 
+        if (!isIncremental)
+            fillAllTile();
+
         if (getMinMaxWindowMetalArea().first < minMetalAreaConstraint)
         {
+            // fill again without the free regions being cut at the tile borders
             initGrid();
-
-            std::vector<geometry::Rectangle> freeRegions = getAllFreeRegion(numTileRow, numTileCol);
-            freeRegions = refineFreeRegion(freeRegions);
-            for (const geometry::Rectangle &freeRegion : freeRegions)
-            {
-                geometry::Rectangle *newFreeRegion = new geometry::Rectangle(freeRegion);
-                allCandidateRegions.emplace_back(newFreeRegion);
-                recordFreeRegion(newFreeRegion);
-            }
-
-            std::vector<geometry::Rectangle> fillers = generateAllFiller(freeRegions);
-            for (const geometry::Rectangle &filler : fillers)
-            {
-                process::Filler *newFiller = new process::Filler(filler, coverByOneTile(filler));
-                allFillers.emplace_back(newFiller);
-                insertFiller(newFiller);
-            }
+            if (db->isPartial)
+                fillDirtyTile(true);
+            else
+                fillRegion(db->chipBoundary);
         }
         minMaxDensity = getMinMaxWindowMetalDensity();
         printf("Min/Max density (fill all fillers):   %.4lf %.4lf\n", minMaxDensity.first, minMaxDensity.second);
+        recordMemory("fill all fillers", resultWriter);
+        size_t numLookup = numPatternLookup, numHit = numPatternHit;
+        printf("Pattern cache hits/lookups:           %zu %zu (%.2lf%%)\n", numHit, numLookup,
+               numLookup ? 100.0 * numHit / numLookup : 0.0);
+        if (timer)
+            layerMandatoryTime += timer->getElapsedTime() - layerStartTime;
 
         removeCriticalNetFiller();
         minMaxDensity = getMinMaxWindowMetalDensity();
         printf("Min/Max density (reduce capacitance): %.4lf %.4lf\n", minMaxDensity.first, minMaxDensity.second);
+        recordMemory("reduce capacitance", resultWriter);
 
+        std::chrono::milliseconds passStartTime = timer ? timer->getElapsedTime() : std::chrono::milliseconds(0);
         meetDensityConstraint();
         minMaxDensity = getMinMaxWindowMetalDensity();
         printf("Min/Max density (meet metal density): %.4lf %.4lf\n", minMaxDensity.first, minMaxDensity.second);
+        recordMemory("meet metal density", resultWriter);
+        if (timer)
+            layerMandatoryTime += timer->getElapsedTime() - passStartTime;
 
         removeMoreFiller();
         minMaxDensity = getMinMaxWindowMetalDensity();
         printf("Min/Max density (reduce filler):      %.4lf %.4lf\n", minMaxDensity.first, minMaxDensity.second);
+        recordMemory("reduce filler", resultWriter);
+
+        passStartTime = timer ? timer->getElapsedTime() : std::chrono::milliseconds(0);
+        insertBackFiller();
+        minMaxDensity = getMinMaxWindowMetalDensity();
+        printf("Min/Max density (insert back filler): %.4lf %.4lf\n", minMaxDensity.first, minMaxDensity.second);
+        recordMemory("insert back filler", resultWriter);
+        if (timer)
+            layerMandatoryTime += timer->getElapsedTime() - passStartTime;
+
+        size_t numFiller = getAllInsertedFiller().size();
+        mergeAllFiller();
+        std::vector<process::Filler *> fillers = getAllInsertedFiller();
+        minMaxDensity = getMinMaxWindowMetalDensity();
+        printf("Min/Max density (merge filler):       %.4lf %.4lf\n", minMaxDensity.first, minMaxDensity.second);
+        recordMemory("merge filler", resultWriter);
+        std::cout << "#fillers (before/after merging):      " << numFiller << " " << fillers.size() << "\n";
+        if (!rasterPrefix.empty())
+            writeRaster(fillers);
+        if (isOverTime())
+            std::cout << "[Warning] Time limit exceeded. Only the mandatory passes are run.\n";
+        else if (isOverLayerTime())
+            std::cout << "[Warning] Layer time budget exceeded. Optional passes are cut short.\n";
 
         std::cout << "\n";
 
-        std::unordered_set<geometry::Rectangle *> fillerSet;
-        for (const std::vector<process::Tile> &row : tileGrid)
-            for (const process::Tile &tile : row)
-                for (process::Filler *filler : tile.fillerSet)
-                    fillerSet.emplace(filler);
-        for (const geometry::Rectangle *filler : fillerSet)
+        for (const process::Filler *filler : fillers)
             resultWriter->addFiller(*filler, layer->id);
+        mandatoryTime = std::max(mandatoryTime, layerMandatoryTime);
     }
     return std::unique_ptr<ResultWriter>(resultWriter);
 }
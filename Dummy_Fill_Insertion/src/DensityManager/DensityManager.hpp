@@ -1,66 +1,149 @@
 #pragma once
 #include "../ResultWriter/ResultWriter.hpp"
 #include "../Structure/Process/Process.hpp"
+#include "../Timer/Progress.hpp"
+#include "../Timer/Timer.hpp"
+#include "WorkerPool.hpp"
+#include <chrono>
 #include <cmath>
+#include <deque>
 #include <functional>
 #include <ostream>
+#include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 class DensityManager
 {
+    friend class Benchmark;
+    friend class Fuzz;
+
     process::Database *db;
     size_t numTileForWindow; // window size(width) / step size(width)
+    size_t numThread;        // tiles filled or repaired at once, 1 for the serial passes only
+    WorkerPool::ptr workerPool; // numThread threads for all the layers, null for 1
+    Timer *timer;
+    std::chrono::milliseconds layerTimeLimit; // time budget of the current layer, optional passes stop after it
+    std::chrono::milliseconds mandatoryTime;  // max time spent on the mandatory passes of a layer so far
+    std::string rasterPrefix;                 // images of every solved layer, empty for none
+    int64_t rasterResolution;                 // database units per pixel, 0 for choosing automatically
+    bool isRasterCoverage;                    // also the conductor and filler coverage, not only the density heatmap
 
     int64_t tileSize; // equal to step size
     int64_t tileArea, windowArea;
     size_t numTileRow, numTileCol;
+    size_t windowBeginRow, windowBeginCol; // tile row/col index of the first window
     size_t numWindowRow, numWindowCol;
 
     process::Layer *layer;
     int64_t lowerLeftSpacing, upperRightSpacing;            // for spacing buffer expanding
     int64_t minMetalAreaConstraint, maxMetalAreaConstraint; // min/max metal area constraint for a window
 
-    std::vector<geometry::Rectangle::ptr> allCandidateRegions;
+    // free regions and fillers of a tile relative to its lower-left corner, shared by the tiles with the same obstacles
+    struct Pattern
+    {
+        std::vector<geometry::CompactRectangle> freeRegions, fillers;
+    };
+    struct PatternHash
+    {
+        size_t operator()(const std::vector<int32_t> &key) const;
+    };
+    static constexpr size_t maxNumPattern = 1 << 16;
+
+    using KeyToPattern = std::vector<std::pair<std::vector<int32_t>, Pattern>>;
+
+    std::unordered_map<std::vector<int32_t>, Pattern, PatternHash> patternCache; // keyed by the layer rules and the obstacles
+    std::atomic<size_t> numPatternLookup, numPatternHit;                         // of the current layer
+
+    std::deque<geometry::CompactRectangle> allCandidateRegions; // stable addresses, referred to by the tiles
     std::vector<process::Filler::ptr> allFillers;
     std::vector<std::vector<process::Tile>> tileGrid;
-    std::vector<std::vector<int64_t>> windowGrid; // record window metal area
+    std::vector<std::vector<process::AtomicArea>> windowGrid; // record window metal area
 
-    std::pair<size_t, size_t> getTileIdx(
-        int64_t x, int64_t y, std::function<double(double)> func = [](double d) -> bool
-        { return std::floor(d); }) const;
-    std::tuple<size_t, size_t, size_t, size_t> getTileIdx(const geometry::Rectangle &boundary) const;
-    bool coverByOneTile(const geometry::Rectangle &boundary) const;
+    std::pair<size_t, size_t> getTileIdx(int64_t x, int64_t y) const;
+    std::tuple<size_t, size_t, size_t, size_t> getTileIdx(const geometry::CompactRectangle &boundary) const;
+    bool coverByOneTile(const geometry::CompactRectangle &boundary) const;
     std::pair<int64_t, int64_t> getTilePos(size_t rowIdx, size_t colIdx) const;
     void updateAllWindowMetalArea();
     std::pair<int64_t, int64_t> getMinMaxWindowMetalArea() const;
+    // [begin, end) window rows and columns of the windows containing a tile, derived from its position
+    std::tuple<size_t, size_t, size_t, size_t> getWindowIdx(const process::Tile &tile) const;
+    std::pair<int64_t, int64_t> getMinMaxWindowMetalArea(const process::Tile &tile) const;
+    void addWindowMetalArea(const process::Tile &tile, int64_t area);
     std::pair<double, double> getMinMaxWindowMetalDensity() const;
+    int64_t getMaxWindowMetalArea(const geometry::CompactRectangle &boundary) const;
+    process::Tile::Kind getTileKind(const process::Tile &tile) const;
     int64_t getConductorArea(const process::Tile &tile) const;
+    bool isOverTime() const;
+    bool isOverLayerTime() const;
+    // names a pass of the current layer in the progress reports, with the window density as seen by the reporter
+    Progress::Phase trackProgress(const std::string &pass, uint64_t numTile = 0) const;
+    // record the solver structures in the memory report, take a snapshot after a phase and print it
+    void recordMemory(const std::string &phase, const ResultWriter *resultWriter) const;
 
     void initProcessLayer(process::Layer *layer_);
     void initGrid();
-    void recordFreeRegion(geometry::Rectangle *freeRegion);
+    void recordFreeRegion(geometry::CompactRectangle *freeRegion);
     void insertFiller(process::Filler *filler);
     void removeFiller(process::Filler *filler);
+    bool isInserted(process::Filler *filler) const;
+    std::vector<process::Filler *> getAllInsertedFiller() const;
 
-    std::vector<geometry::Rectangle> getAllFreeRegion(size_t rowIdx, size_t colIdx) const;
-    std::vector<geometry::Rectangle> refineFreeRegion(const std::vector<geometry::Rectangle> &freeRegions) const;
-    std::vector<geometry::Rectangle> filterIllegalRegion(const std::vector<geometry::Rectangle> &freeRegions) const;
-    std::vector<geometry::Rectangle> generateAllFiller(const std::vector<geometry::Rectangle> &freeRegions) const;
+    bool isClearTile(size_t rowIdx, size_t colIdx) const;
+    // the free-region functions clear and fill a caller-provided output buffer, so that it can be reused across tiles
+    void getNearObstacle(size_t rowIdx, size_t colIdx, std::vector<geometry::CompactRectangle> &conductors) const;
+    void getPatternKey(const process::Tile &tile, std::vector<geometry::CompactRectangle> &obstacles, std::vector<int32_t> &key) const;
+    template <process::Layer::Direction direction>
+    void sweepFreeRegion(const geometry::CompactRectangle &boundary, const std::vector<geometry::CompactRectangle> &conductors,
+                         std::vector<geometry::CompactRectangle> &freeRegions) const;
+    template <process::Layer::Direction direction>
+    void getAllFreeRegion(size_t rowIdx, size_t colIdx, std::vector<geometry::CompactRectangle> &freeRegions) const;
+    void getAllFreeRegion(size_t rowIdx, size_t colIdx, std::vector<geometry::CompactRectangle> &freeRegions) const;
+    void getAllFreeRegion(const geometry::CompactRectangle &boundary, std::vector<geometry::CompactRectangle> &freeRegions) const;
+    template <process::Layer::Direction direction>
+    void refineFreeRegion(const std::vector<geometry::CompactRectangle> &freeRegions, std::vector<geometry::CompactRectangle> &refinedRegions) const;
+    void refineFreeRegion(const std::vector<geometry::CompactRectangle> &freeRegions, std::vector<geometry::CompactRectangle> &refinedRegions) const;
+    void filterIllegalRegion(const std::vector<geometry::CompactRectangle> &freeRegions, std::vector<geometry::CompactRectangle> &legalRegions) const;
+    void generateAllFiller(const std::vector<geometry::CompactRectangle> &freeRegions, std::vector<geometry::CompactRectangle> &fillers) const;
+    void getTileFiller(size_t rowIdx, size_t colIdx, std::vector<geometry::CompactRectangle> &freeRegions,
+                       std::vector<geometry::CompactRectangle> &fillers, KeyToPattern *missedPatterns = nullptr);
+    void fillTile(size_t rowIdx, size_t colIdx);
+    std::vector<std::vector<std::pair<size_t, size_t>>> getTileColour(size_t period) const;
+    void runConcurrently(const std::vector<std::pair<size_t, size_t>> &tiles,
+                         const std::function<void(size_t rowIdx, size_t colIdx, size_t threadIdx)> &func) const;
+    void fillAllTile();
+    void fillRegion(const geometry::CompactRectangle &boundary);
+    std::vector<std::pair<size_t, size_t>> markDirtyTile();
+    bool fillDirtyTile(bool isWholeRegion = false); // fill the refilled tiles one by one or as one region
     void removeCriticalNetFiller();
+    void removeInTileFillerConcurrently(bool isMeetDensity);
     void meetDensityConstraint();
     void removeMoreFiller();
+    int64_t getDeficitRelief(process::Filler *filler) const;
+    void insertBackFiller();
+    bool isFreeGap(const geometry::CompactRectangle &gap, const process::Filler *former, const process::Filler *latter) const;
+    bool mergeFiller(process::Filler *former, process::Filler *latter, bool isHorizontal);
+    void mergeAllFiller();
+    void writeRaster(const std::vector<process::Filler *> &fillers) const;
 
     // for debug
     int64_t getOccupyAreaBruteForce(const process::Tile &tile) const;
-    void drawBorder(std::vector<std::vector<char>> &detailGrid, const geometry::Rectangle &boundary,
-                    const geometry::Rectangle &region, double scaling, char h = '-', char v = '|') const;
-    void drawRegion(std::vector<std::vector<char>> &detailGrid, const geometry::Rectangle &boundary,
-                    const geometry::Rectangle &region, double scaling, char c = '.') const;
+    void drawBorder(std::vector<std::vector<char>> &detailGrid, const geometry::CompactRectangle &boundary,
+                    const geometry::CompactRectangle &region, double scaling, char h = '-', char v = '|') const;
+    void drawRegion(std::vector<std::vector<char>> &detailGrid, const geometry::CompactRectangle &boundary,
+                    const geometry::CompactRectangle &region, double scaling, char c = '.') const;
     void drawTile(std::ostream &output, size_t rowIdx, size_t colIdx, bool drawFiller = true, double scaling = 0.2) const;
     void drawWindow(std::ostream &output, size_t rowIdx, size_t colIdx, bool drawFiller = true, double scaling = 0.05) const;
 
 public:
-    DensityManager(process::Database *db_, size_t numTileForWindow_ = 4);
+    static constexpr size_t numStepForWindow = 4; // windows are checked at a step of window size / 4
+
+    static bool isValidNumTileForWindow(int64_t windowSize, size_t numTileForWindow);
+    static size_t getAutoNumTileForWindow(const process::Database *db);
+    DensityManager(process::Database *db_, size_t numTileForWindow_ = 4, Timer *timer_ = nullptr, size_t numThread_ = 1);
+    ~DensityManager();
+    // write <prefix>.<layer id>.density.ppm (and .conductor.pgm, .filler.pgm) after solving each layer
+    void setRaster(const std::string &filePrefix, int64_t resolution = 0, bool isCoverage = false);
     ResultWriter::ptr solve();
 };
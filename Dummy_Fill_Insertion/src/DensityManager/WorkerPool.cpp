@@ -0,0 +1,64 @@
+#include "WorkerPool.hpp"
+
+WorkerPool::WorkerPool(size_t numThread) : job(nullptr), generation(0), numRunningWorker(0), isStopping(false)
+{
+    for (size_t threadIdx = 1; threadIdx < numThread; ++threadIdx)
+        workers.emplace_back(&WorkerPool::work, this, threadIdx);
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        isStopping = true;
+    }
+    startCondition.notify_all();
+    for (std::thread &worker : workers)
+        worker.join();
+}
+
+void WorkerPool::work(size_t threadIdx)
+{
+    uint64_t doneGeneration = 0;
+    while (true)
+    {
+        const std::function<void(size_t)> *curJob;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            startCondition.wait(lock, [&]()
+                                { return isStopping || generation != doneGeneration; });
+            if (isStopping)
+                return;
+            doneGeneration = generation;
+            curJob = job;
+        }
+
+        (*curJob)(threadIdx);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--numRunningWorker == 0)
+            doneCondition.notify_one();
+    }
+}
+
+void WorkerPool::run(const std::function<void(size_t threadIdx)> &job_)
+{
+    if (workers.empty())
+    {
+        job_(0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &job_;
+        numRunningWorker = workers.size();
+        ++generation;
+    }
+    startCondition.notify_all();
+    job_(0);
+
+    // the barrier between two jobs: the next one starts only after every worker is done with this one
+    std::unique_lock<std::mutex> lock(mutex);
+    doneCondition.wait(lock, [&]()
+                       { return numRunningWorker == 0; });
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Worker threads kept for the lifetime of the solver. A pass over tile
+// colours hands every colour to the same threads and waits for all of them
+// before the next one, instead of creating and joining threads per colour,
+// so the thread_local scratch buffers of the workers stay warm across the
+// colours, the passes and the layers.
+class WorkerPool
+{
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable startCondition, doneCondition;
+    const std::function<void(size_t threadIdx)> *job; // of the current generation
+    uint64_t generation;                               // bumped for every job
+    size_t numRunningWorker;
+    bool isStopping;
+
+    void work(size_t threadIdx);
+
+public:
+    using ptr = std::unique_ptr<WorkerPool>;
+
+    explicit WorkerPool(size_t numThread); // the calling thread counts as one
+    ~WorkerPool();
+    size_t size() const { return workers.size() + 1; }
+    // job(threadIdx) on every thread, the calling thread as 0, and return after all of them are done
+    void run(const std::function<void(size_t threadIdx)> &job_);
+};
@@ -0,0 +1,475 @@
+#include "Fuzz.hpp"
+#include "../DensityManager/DensityManager.hpp"
+#include "../Structure/Geometry/RectangleBatch.hpp"
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <tuple>
+
+namespace
+{
+    // number of rectangles covering each unit cell of a boundary
+    struct Raster
+    {
+        geometry::CompactRectangle boundary;
+        std::vector<uint8_t> cells;
+
+        Raster(const geometry::CompactRectangle &boundary_)
+            : boundary(boundary_), cells(static_cast<size_t>(boundary_.width()) * boundary_.height(), 0) {}
+
+        void add(const geometry::CompactRectangle &rectangle)
+        {
+            geometry::CompactRectangle region = geometry::getIntersectRegion(boundary, rectangle);
+            for (int32_t y = region.y1; y < region.y2; ++y)
+                for (int32_t x = region.x1; x < region.x2; ++x)
+                {
+                    uint8_t &cell = cells[static_cast<size_t>(y - boundary.y1) * boundary.width() + (x - boundary.x1)];
+                    cell = std::min(cell + 1, 255);
+                }
+        }
+        uint8_t at(int32_t x, int32_t y) const
+        {
+            return cells[static_cast<size_t>(y - boundary.y1) * boundary.width() + (x - boundary.x1)];
+        }
+        int64_t getCoveredArea(const geometry::CompactRectangle &rectangle) const
+        {
+            int64_t area = 0;
+            geometry::CompactRectangle region = geometry::getIntersectRegion(boundary, rectangle);
+            for (int32_t y = region.y1; y < region.y2; ++y)
+                for (int32_t x = region.x1; x < region.x2; ++x)
+                    area += at(x, y) > 0;
+            return area;
+        }
+    };
+
+    bool isInside(const geometry::CompactRectangle &rectangle, const geometry::CompactRectangle &boundary)
+    {
+        return boundary.x1 <= rectangle.x1 && boundary.y1 <= rectangle.y1 && rectangle.x2 <= boundary.x2 && rectangle.y2 <= boundary.y2;
+    }
+
+    // the regions must be legal, inside the boundary, disjoint and clear of the blocked cells, and cover every free cell if isExact
+    std::string checkCover(const std::string &name, const geometry::CompactRectangle &boundary,
+                           const std::vector<geometry::CompactRectangle> &regions, const Raster &blocked, bool isExact)
+    {
+        Raster cover(boundary);
+        for (const geometry::CompactRectangle &region : regions)
+        {
+            if (!region.isLegal() || !isInside(region, boundary))
+                return name + ": (" + region.dumpCoordinates() + ") is not inside (" + boundary.dumpCoordinates() + ")";
+            cover.add(region);
+        }
+        for (int32_t y = boundary.y1; y < boundary.y2; ++y)
+        {
+            for (int32_t x = boundary.x1; x < boundary.x2; ++x)
+            {
+                std::string cell = "(" + std::to_string(x) + ", " + std::to_string(y) + ")";
+                if (cover.at(x, y) > 1)
+                    return name + ": overlap at the cell " + cell;
+                if (cover.at(x, y) == 1 && blocked.at(x, y) > 0)
+                    return name + ": covers the blocked cell " + cell;
+                if (isExact && cover.at(x, y) == 0 && blocked.at(x, y) == 0)
+                    return name + ": misses the free cell " + cell;
+            }
+        }
+        return "";
+    }
+
+    std::vector<geometry::CompactRectangle> getSorted(std::vector<geometry::CompactRectangle> rectangles)
+    {
+        std::sort(rectangles.begin(), rectangles.end(), [](const geometry::CompactRectangle &a, const geometry::CompactRectangle &b) -> bool
+                  { return std::tie(a.x1, a.y1, a.x2, a.y2) < std::tie(b.x1, b.y1, b.x2, b.y2); });
+        return rectangles;
+    }
+
+    bool isSame(const std::vector<geometry::CompactRectangle> &a, const std::vector<geometry::CompactRectangle> &b)
+    {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](const geometry::CompactRectangle &p, const geometry::CompactRectangle &q) -> bool
+                                                  { return std::tie(p.x1, p.y1, p.x2, p.y2) == std::tie(q.x1, q.y1, q.x2, q.y2); });
+    }
+}
+
+void Fuzz::Case::write(std::ostream &output) const
+{
+    process::Layer layer;
+    layer.direction = direction;
+    output << "tile size " << tileSize << ", " << numTileCol << " x " << numTileRow << " tiles, " << layer.directionName()
+           << ", min spacing " << minSpacing << ", fill width " << minFillWidth << " to " << maxFillWidth << "\n";
+    for (const geometry::CompactRectangle &conductor : conductors)
+        output << "conductor " << conductor.dumpCoordinates() << "\n";
+    for (const geometry::CompactRectangle &filler : fillers)
+        output << "filler    " << filler.dumpCoordinates() << "\n";
+}
+
+std::string Fuzz::checkConductorArea(DensityManager &densityManager, const Case &fuzzCase)
+{
+    Raster conductorRaster(densityManager.db->chipBoundary);
+    for (const geometry::CompactRectangle &conductor : fuzzCase.conductors)
+        conductorRaster.add(conductor);
+
+    for (size_t rowIdx = 0; rowIdx < densityManager.numTileRow; ++rowIdx)
+    {
+        for (size_t colIdx = 0; colIdx < densityManager.numTileCol; ++colIdx)
+        {
+            const process::Tile &tile = densityManager.tileGrid[rowIdx][colIdx];
+            int64_t area = conductorRaster.getCoveredArea(tile);
+            std::stringstream ss;
+            ss << "conductor area: tile (" << rowIdx << ", " << colIdx << ") ";
+            if (tile.conductorArea != area)
+            {
+                ss << "of kind " << static_cast<int>(tile.kind) << " gets " << tile.conductorArea << " from initGrid, expected " << area;
+                return ss.str();
+            }
+            int64_t sweptArea = densityManager.getConductorArea(tile);
+            if (sweptArea != area)
+            {
+                ss << "gets " << sweptArea << " from getConductorArea, expected " << area;
+                return ss.str();
+            }
+        }
+    }
+    return "";
+}
+
+std::string Fuzz::checkFreeRegion(DensityManager &densityManager, const Case &fuzzCase)
+{
+    // a conductor or an inserted filler blocks the cells within half the spacing, as in the solver
+    const geometry::CompactRectangle &chipBoundary = densityManager.db->chipBoundary;
+    Raster blocked(chipBoundary);
+    for (const std::vector<geometry::CompactRectangle> *rectangles : {&fuzzCase.conductors, &fuzzCase.fillers})
+    {
+        for (geometry::CompactRectangle rectangle : *rectangles)
+        {
+            rectangle.expand(densityManager.lowerLeftSpacing, densityManager.upperRightSpacing);
+            blocked.add(rectangle);
+        }
+    }
+    int64_t minRegionWidth = fuzzCase.minFillWidth + densityManager.lowerLeftSpacing + densityManager.upperRightSpacing;
+
+    std::vector<geometry::CompactRectangle> sweptRegions, refinedRegions, fillers, expandedFillers, patternRegions, patternFillers;
+    for (size_t rowIdx = 0; rowIdx < densityManager.numTileRow; ++rowIdx)
+    {
+        for (size_t colIdx = 0; colIdx < densityManager.numTileCol; ++colIdx)
+        {
+            const geometry::CompactRectangle tile(densityManager.tileGrid[rowIdx][colIdx]);
+            std::string tileName = " of tile (" + std::to_string(rowIdx) + ", " + std::to_string(colIdx) + ")";
+
+            densityManager.getAllFreeRegion(rowIdx, colIdx, sweptRegions);
+            std::string failure = checkCover("free region" + tileName, tile, sweptRegions, blocked, true);
+            if (!failure.empty())
+                return failure;
+
+            densityManager.refineFreeRegion(sweptRegions, refinedRegions);
+            for (const geometry::CompactRectangle &region : refinedRegions)
+                if (region.width() < minRegionWidth || region.height() < minRegionWidth)
+                    return "refined region" + tileName + ": (" + region.dumpCoordinates() + ") is narrower than " + std::to_string(minRegionWidth);
+            failure = checkCover("refined region" + tileName, tile, refinedRegions, blocked, false);
+            if (!failure.empty())
+                return failure;
+            // merging only grows the regions, so the legal swept regions stay covered
+            Raster refinedCover(tile);
+            for (const geometry::CompactRectangle &region : refinedRegions)
+                refinedCover.add(region);
+            for (const geometry::CompactRectangle &region : sweptRegions)
+                if (region.width() >= minRegionWidth && region.height() >= minRegionWidth && refinedCover.getCoveredArea(region) != region.area())
+                    return "refined region" + tileName + ": drops a part of the legal free region (" + region.dumpCoordinates() + ")";
+
+            densityManager.generateAllFiller(refinedRegions, fillers);
+            expandedFillers.clear();
+            for (geometry::CompactRectangle filler : fillers)
+            {
+                if (filler.width() < fuzzCase.minFillWidth || filler.height() < fuzzCase.minFillWidth ||
+                    filler.width() > fuzzCase.maxFillWidth || filler.height() > fuzzCase.maxFillWidth)
+                    return "filler" + tileName + ": (" + filler.dumpCoordinates() + ") breaks the fill width";
+                expandedFillers.emplace_back(filler.expand(densityManager.lowerLeftSpacing, densityManager.upperRightSpacing));
+            }
+            failure = checkCover("filler (expanded by the spacing)" + tileName, tile, expandedFillers, blocked, false);
+            if (!failure.empty())
+                return failure;
+
+            // the cached patterns are swept on the obstacles clipped to the tile, relative to its corner
+            densityManager.getTileFiller(rowIdx, colIdx, patternRegions, patternFillers);
+            if (!isSame(getSorted(patternRegions), getSorted(refinedRegions)) || !isSame(getSorted(patternFillers), getSorted(fillers)))
+            {
+                std::stringstream ss;
+                ss << "pattern cache" << tileName << ": " << patternRegions.size() << " regions and " << patternFillers.size()
+                   << " fillers, the direct kernels give " << refinedRegions.size() << " and " << fillers.size();
+                return ss.str();
+            }
+        }
+    }
+
+    densityManager.getAllFreeRegion(chipBoundary, sweptRegions);
+    return checkCover("region sweep", chipBoundary, sweptRegions, blocked, true);
+}
+
+bool Fuzz::isSameCheck(const std::string &failure, const std::string &otherFailure)
+{
+    // the check is the name before " of tile" or ":"
+    auto getCheckName = [](const std::string &str) -> std::string
+    {
+        return str.substr(0, std::min(str.find(" of tile"), str.find(':')));
+    };
+    return !otherFailure.empty() && getCheckName(failure) == getCheckName(otherFailure);
+}
+
+Fuzz::Case Fuzz::generate(uint64_t seed, int32_t maxTileSize)
+{
+    std::mt19937_64 rng(seed);
+    auto uniform = [&](int64_t lower, int64_t upper) -> int64_t
+    {
+        return std::uniform_int_distribution<int64_t>(lower, upper)(rng);
+    };
+
+    Case fuzzCase;
+    fuzzCase.tileSize = uniform(4, std::max(maxTileSize, 4));
+    fuzzCase.numTileRow = uniform(4, 6);
+    fuzzCase.numTileCol = uniform(4, 6);
+    fuzzCase.direction = uniform(0, 1) ? process::Layer::Direction::HORIZONTAL : process::Layer::Direction::VERTICAL;
+    fuzzCase.minSpacing = uniform(1, fuzzCase.tileSize / 2);
+    fuzzCase.minFillWidth = uniform(1, std::max(fuzzCase.tileSize / 3, 1));
+    fuzzCase.maxFillWidth = uniform(fuzzCase.minFillWidth, 2 * fuzzCase.tileSize);
+
+    // half of the coordinates on a tile border or a spacing away from one
+    auto getCoordinate = [&](int32_t size) -> int32_t
+    {
+        int64_t kind = uniform(0, 5);
+        int64_t border = uniform(0, size / fuzzCase.tileSize) * fuzzCase.tileSize;
+        if (kind < 2)
+            return border;
+        if (kind == 2)
+            return std::clamp<int64_t>(border + uniform(-fuzzCase.minSpacing, fuzzCase.minSpacing), 0, size);
+        return uniform(0, size);
+    };
+    auto getRectangle = [&]() -> geometry::CompactRectangle
+    {
+        int32_t width = fuzzCase.numTileCol * fuzzCase.tileSize, height = fuzzCase.numTileRow * fuzzCase.tileSize;
+        while (true)
+        {
+            int32_t x1 = getCoordinate(width), x2 = getCoordinate(width), y1 = getCoordinate(height), y2 = getCoordinate(height);
+            if (x1 != x2 && y1 != y2)
+                return geometry::CompactRectangle(std::min(x1, x2), std::min(y1, y2), std::max(x1, x2), std::max(y1, y2));
+        }
+    };
+    // a third of the conductors are stacked on an earlier one: a copy, a part of it or a shifted copy
+    auto getStackedRectangle = [&](const geometry::CompactRectangle &base) -> geometry::CompactRectangle
+    {
+        int64_t kind = uniform(0, 2);
+        if (kind == 0)
+            return base;
+        if (kind == 1)
+        {
+            int32_t x1 = uniform(base.x1, base.x2 - 1), y1 = uniform(base.y1, base.y2 - 1);
+            return geometry::CompactRectangle(x1, y1, uniform(x1 + 1, base.x2), uniform(y1 + 1, base.y2));
+        }
+        int32_t width = fuzzCase.numTileCol * fuzzCase.tileSize, height = fuzzCase.numTileRow * fuzzCase.tileSize;
+        int32_t dx = uniform(1 - base.width(), base.width() - 1), dy = uniform(1 - base.height(), base.height() - 1);
+        geometry::CompactRectangle shifted(std::max(base.x1 + dx, 0), std::max(base.y1 + dy, 0),
+                                           std::min(base.x2 + dx, width), std::min(base.y2 + dy, height));
+        return (shifted.x1 < shifted.x2 && shifted.y1 < shifted.y2) ? shifted : base;
+    };
+    for (int64_t numConductor = uniform(0, 12); numConductor > 0; --numConductor)
+    {
+        if (!fuzzCase.conductors.empty() && uniform(0, 2) == 0)
+            fuzzCase.conductors.emplace_back(getStackedRectangle(fuzzCase.conductors[uniform(0, fuzzCase.conductors.size() - 1)]));
+        else
+            fuzzCase.conductors.emplace_back(getRectangle());
+    }
+    for (int64_t numFiller = uniform(0, 3); numFiller > 0; --numFiller)
+        fuzzCase.fillers.emplace_back(getRectangle());
+    return fuzzCase;
+}
+
+std::string Fuzz::check(const Case &fuzzCase)
+{
+    process::Database db;
+    db.chipBoundary = geometry::CompactRectangle(0, 0, fuzzCase.numTileCol * fuzzCase.tileSize, fuzzCase.numTileRow * fuzzCase.tileSize);
+    db.windowBoundary = db.chipBoundary;
+    db.windowSize = 4 * fuzzCase.tileSize;
+    process::Layer *layer = new process::Layer();
+    layer->id = 1;
+    layer->direction = fuzzCase.direction;
+    layer->minSpacing = fuzzCase.minSpacing;
+    layer->minFillWidth = fuzzCase.minFillWidth;
+    layer->maxFillWidth = fuzzCase.maxFillWidth;
+    for (size_t idx = 0; idx < fuzzCase.conductors.size(); ++idx)
+        layer->conductors.emplace_back(fuzzCase.conductors[idx], idx, false);
+    db.layers.emplace_back(layer);
+
+    std::streambuf *coutBuffer = std::cout.rdbuf(nullptr);
+    DensityManager densityManager(&db, 4);
+    std::cout.rdbuf(coutBuffer);
+    std::cout.clear();
+    densityManager.initProcessLayer(layer);
+    densityManager.initGrid();
+    for (const geometry::CompactRectangle &filler : fuzzCase.fillers)
+    {
+        process::Filler *newFiller = new process::Filler(filler, densityManager.coverByOneTile(filler));
+        densityManager.allFillers.emplace_back(newFiller);
+        densityManager.insertFiller(newFiller);
+    }
+
+    std::string failure = checkConductorArea(densityManager, fuzzCase);
+    if (failure.empty())
+        failure = checkFreeRegion(densityManager, fuzzCase);
+    return failure;
+}
+
+std::string Fuzz::checkRectangleBatch(uint64_t seed)
+{
+    std::mt19937_64 rng(seed);
+    auto uniform = [&](int64_t lower, int64_t upper) -> int64_t
+    {
+        return std::uniform_int_distribution<int64_t>(lower, upper)(rng);
+    };
+
+    // a narrow range around 0 makes touching edges, zero overlaps and negative coordinates common,
+    // and up to 37 rectangles leave tails of every length after the 8- and 4-wide blocks
+    int32_t range = uniform(0, 1) ? 6 : (1 << 29);
+    auto getRectangle = [&]() -> geometry::CompactRectangle
+    {
+        int32_t x1 = uniform(-range, range - 1), y1 = uniform(-range, range - 1);
+        return geometry::CompactRectangle(x1, y1, uniform(x1 + 1, range), uniform(y1 + 1, range));
+    };
+    geometry::RectangleBatch batch;
+    for (int64_t numRectangle = uniform(0, 37); numRectangle > 0; --numRectangle)
+        batch.emplace_back(getRectangle());
+
+    // half of the queries share an edge coordinate with a rectangle of the batch
+    std::vector<geometry::CompactRectangle> queries;
+    for (int numQuery = 0; numQuery < 8; ++numQuery)
+    {
+        geometry::CompactRectangle query = getRectangle();
+        if (batch.size() > 0 && uniform(0, 1))
+        {
+            geometry::CompactRectangle rectangle = batch[uniform(0, batch.size() - 1)];
+            int32_t width = query.width(), height = query.height();
+            switch (uniform(0, 3))
+            {
+            case 0:
+                query = geometry::CompactRectangle(rectangle.x2, query.y1, rectangle.x2 + width, query.y2);
+                break;
+            case 1:
+                query = geometry::CompactRectangle(rectangle.x1 - width, query.y1, rectangle.x1, query.y2);
+                break;
+            case 2:
+                query = geometry::CompactRectangle(query.x1, rectangle.y2, query.x2, rectangle.y2 + height);
+                break;
+            default:
+                query = geometry::CompactRectangle(rectangle.x2, rectangle.y2, rectangle.x2 + width, rectangle.y2 + height);
+                break;
+            }
+        }
+        queries.emplace_back(query);
+    }
+
+    std::string failure;
+    std::vector<uint32_t> indices;
+    std::vector<int64_t> distances, lengths;
+    for (const std::string &kernel : geometry::RectangleBatch::getSupportedKernelNames())
+    {
+        geometry::RectangleBatch::setKernel(kernel);
+        for (const geometry::CompactRectangle &query : queries)
+        {
+            indices.clear();
+            batch.selectIntersect(query, indices);
+            batch.getDistance(query, distances);
+            batch.getParallelLength(query, lengths);
+            std::vector<uint32_t> expectedIndices;
+            for (size_t idx = 0; idx < batch.size(); ++idx)
+            {
+                geometry::CompactRectangle rectangle = batch[idx];
+                std::string pair = " of (" + query.dumpCoordinates() + ") and (" + rectangle.dumpCoordinates() + ") in a batch of " +
+                                   std::to_string(batch.size());
+                if (geometry::isIntersect(query, rectangle))
+                    expectedIndices.emplace_back(idx);
+                if (distances[idx] != geometry::getDistance(query, rectangle))
+                    failure = kernel + " getDistance: " + std::to_string(distances[idx]) + pair;
+                else if (lengths[idx] != geometry::getParallelLength(query, rectangle))
+                    failure = kernel + " getParallelLength: " + std::to_string(lengths[idx]) + pair;
+                if (!failure.empty())
+                    break;
+            }
+            if (failure.empty() && indices != expectedIndices)
+                failure = kernel + " selectIntersect: " + std::to_string(indices.size()) + " of " + std::to_string(batch.size()) +
+                          " rectangles intersect (" + query.dumpCoordinates() + "), expected " + std::to_string(expectedIndices.size());
+            if (!failure.empty())
+                break;
+        }
+        if (!failure.empty())
+            break;
+    }
+    geometry::RectangleBatch::setKernel(geometry::RectangleBatch::getSupportedKernelNames().front());
+    return failure;
+}
+
+Fuzz::Case Fuzz::shrink(const Case &fuzzCase, const std::string &failure)
+{
+    Case minCase = fuzzCase;
+    auto tryCase = [&](const Case &candidate) -> bool
+    {
+        if (!isSameCheck(failure, check(candidate)))
+            return false;
+        minCase = candidate;
+        return true;
+    };
+
+    bool isShrunk = true;
+    while (isShrunk)
+    {
+        isShrunk = false;
+        for (std::vector<geometry::CompactRectangle> Case::*rectangles : {&Case::conductors, &Case::fillers})
+        {
+            for (size_t idx = 0; idx < (minCase.*rectangles).size();)
+            {
+                Case candidate = minCase;
+                (candidate.*rectangles).erase((candidate.*rectangles).begin() + idx);
+                if (tryCase(candidate))
+                    isShrunk = true;
+                else
+                    ++idx;
+            }
+            // move each border halfway to the opposite one, then by one
+            for (size_t idx = 0; idx < (minCase.*rectangles).size(); ++idx)
+            {
+                for (int border = 0; border < 4; ++border)
+                {
+                    for (bool isHalf : {true, false})
+                    {
+                        Case candidate = minCase;
+                        geometry::CompactRectangle &rectangle = (candidate.*rectangles)[idx];
+                        int32_t width = rectangle.width(), height = rectangle.height();
+                        int32_t step = isHalf ? ((border < 2 ? width : height) / 2) : 1;
+                        if (step == 0 || (border < 2 ? width : height) <= step)
+                            continue;
+                        (border == 0 ? rectangle.x1 : border == 1 ? rectangle.x2 : border == 2 ? rectangle.y1 : rectangle.y2) += (border % 2 == 0) ? step : -step;
+                        if (tryCase(candidate))
+                            isShrunk = true;
+                    }
+                }
+            }
+        }
+
+        // fewer tiles, with the rectangles clipped to the smaller chip
+        for (bool isRow : {true, false})
+        {
+            Case candidate = minCase;
+            size_t &numTile = isRow ? candidate.numTileRow : candidate.numTileCol;
+            if (numTile <= 4)
+                continue;
+            --numTile;
+            geometry::CompactRectangle chipBoundary(0, 0, candidate.numTileCol * candidate.tileSize, candidate.numTileRow * candidate.tileSize);
+            for (std::vector<geometry::CompactRectangle> *rectangles : {&candidate.conductors, &candidate.fillers})
+            {
+                std::vector<geometry::CompactRectangle> clipped;
+                for (const geometry::CompactRectangle &rectangle : *rectangles)
+                    if (geometry::isIntersect(chipBoundary, rectangle))
+                        clipped.emplace_back(geometry::getIntersectRegion(chipBoundary, rectangle));
+                rectangles->swap(clipped);
+            }
+            if (tryCase(candidate))
+                isShrunk = true;
+        }
+    }
+    return minCase;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "../Structure/Process/Process.hpp"
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class DensityManager;
+
+// Differential fuzzing of the tile kernels of DensityManager against
+// rasterized references: every unit cell of a small random chip is marked as
+// covered or not, which is slow but obviously right. A case is a few tiles
+// with random conductors and inserted fillers, snapped to the tile borders
+// and the spacing offsets now and then, where the kernels have their edge
+// cases. A failing case is shrunk to a minimal one failing the same check.
+class Fuzz
+{
+public:
+    struct Case
+    {
+        int32_t tileSize;
+        size_t numTileRow, numTileCol; // the window is 4 x 4 tiles
+        process::Layer::Direction direction;
+        int64_t minSpacing, minFillWidth, maxFillWidth;
+        std::vector<geometry::CompactRectangle> conductors, fillers; // chip-relative, the fillers are inserted before the checks
+
+        void write(std::ostream &output) const;
+    };
+
+private:
+    static std::string checkConductorArea(DensityManager &densityManager, const Case &fuzzCase);
+    static std::string checkFreeRegion(DensityManager &densityManager, const Case &fuzzCase);
+    static bool isSameCheck(const std::string &failure, const std::string &otherFailure);
+
+public:
+    // the spacing is kept below the tile size, which the neighbour-only obstacle gathering relies on
+    static Case generate(uint64_t seed, int32_t maxTileSize);
+    // empty if the kernels agree with the references, otherwise "<check>: <detail>"
+    static std::string check(const Case &fuzzCase);
+    // greedily drops rectangles, shrinks them and the chip while the same check still fails
+    static Case shrink(const Case &fuzzCase, const std::string &failure);
+    // every kernel of RectangleBatch supported by the CPU against the scalar rectangle functions,
+    // empty if they agree, otherwise "<kernel> <function>: <detail>"
+    static std::string checkRectangleBatch(uint64_t seed);
+};
@@ -0,0 +1,64 @@
+#include "Fuzz.hpp"
+#include <cstdlib>
+#include <iostream>
+#include <unistd.h>
+
+int main(int argc, char *argv[])
+{
+    size_t numCase = 1000;
+    uint64_t seed = 1;
+    int32_t maxTileSize = 32;
+    int opt;
+    while ((opt = getopt(argc, argv, "hn:s:t:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            numCase = std::atoll(optarg);
+            break;
+        case 's':
+            seed = std::strtoull(optarg, nullptr, 10);
+            break;
+        case 't':
+            maxTileSize = std::atoi(optarg);
+            break;
+        default:
+            optind = argc + 1;
+            break;
+        }
+    }
+    if (optind != argc || numCase == 0 || maxTileSize < 4)
+    {
+        std::cerr << "Usage: " << argv[0] << " [-n <#cases>] [-s <first seed>] [-t <max tile size, at least 4>]\n";
+        return 1;
+    }
+
+    // case i is generated from seed + i, so a failing case is run alone with -n 1 -s <its seed>
+    for (size_t caseIdx = 0; caseIdx < numCase; ++caseIdx)
+    {
+        std::string kernelFailure = Fuzz::checkRectangleBatch(seed + caseIdx);
+        if (!kernelFailure.empty())
+        {
+            std::cerr << "[Error] Case " << seed + caseIdx << " fails the " << kernelFailure << "\n";
+            return 1;
+        }
+
+        Fuzz::Case fuzzCase = Fuzz::generate(seed + caseIdx, maxTileSize);
+        std::string failure = Fuzz::check(fuzzCase);
+        if (failure.empty())
+            continue;
+
+        std::cerr << "[Error] Case " << seed + caseIdx << " fails the " << failure << "\n";
+        Fuzz::Case minCase = Fuzz::shrink(fuzzCase, failure);
+        std::cerr << "Shrunk to " << minCase.conductors.size() << " conductors and " << minCase.fillers.size() << " fillers, failing the "
+                  << Fuzz::check(minCase) << ":\n";
+        minCase.write(std::cerr);
+        return 1;
+    }
+    std::cout << "Rectangle batch kernels:";
+    for (const std::string &kernel : geometry::RectangleBatch::getSupportedKernelNames())
+        std::cout << " " << kernel;
+    std::cout << "\n";
+    std::cout << "#cases passed: " << numCase << " (seeds " << seed << " to " << seed + numCase - 1 << ")\n";
+    return 0;
+}
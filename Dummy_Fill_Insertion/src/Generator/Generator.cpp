@@ -0,0 +1,175 @@
+#include "Generator.hpp"
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <fstream>
+#include <iostream>
+
+int64_t Generator::getInteger(int64_t lower, int64_t upper)
+{
+    if (upper <= lower)
+        return lower;
+    return lower + static_cast<int64_t>(engine() % static_cast<uint64_t>(upper - lower + 1));
+}
+
+double Generator::getReal()
+{
+    return (engine() >> 11) * 0x1.0p-53;
+}
+
+double Generator::getGaussian()
+{
+    // Box-Muller transform
+    double u = 1 - getReal(), v = getReal();
+    return std::sqrt(-2 * std::log(u)) * std::cos(2 * M_PI * v);
+}
+
+std::vector<raw::Layer> Generator::getLayers() const
+{
+    // the rules of the shipped testcases: thin lower layers, then wider and sparser ones at the top
+    std::vector<raw::Layer> layers(numLayer);
+    for (size_t layerIdx = 0; layerIdx < numLayer; ++layerIdx)
+    {
+        raw::Layer &layer = layers[layerIdx];
+        double position = static_cast<double>(layerIdx + 1) / numLayer;
+        layer.id = layerIdx + 1;
+        layer.minFillWidth = layer.minSpacing = (position <= 2.0 / 3) ? 65 : (position < 1 || numLayer == 1) ? 130 : 360;
+        layer.maxFillWidth = (layer.minFillWidth < 360) ? 1300 : 3600;
+        layer.minMetalDensity = 0.4;
+        layer.maxMetalDensity = 1;
+        layer.weight = std::max(5 - 0.5 * layerIdx, 1.0);
+    }
+    return layers;
+}
+
+std::vector<int64_t> Generator::getCriticalNets(int64_t numNet)
+{
+    // partial Fisher-Yates shuffle of the net ids
+    size_t numCriticalNet = std::min<size_t>(std::llround(criticalNetRatio * numNet), numNet);
+    std::vector<int64_t> netIds(numNet);
+    for (int64_t netIdx = 0; netIdx < numNet; ++netIdx)
+        netIds[netIdx] = netIdx + 1;
+    for (size_t i = 0; i < numCriticalNet; ++i)
+        std::swap(netIds[i], netIds[getInteger(i, numNet - 1)]);
+    netIds.resize(numCriticalNet);
+    std::sort(netIds.begin(), netIds.end());
+    return netIds;
+}
+
+Generator::Generator()
+    : chipWidth(270000), chipHeight(170000), windowSize(10000), numLayer(9), numConductor(65000),
+      horizontalRatio(0.5), overlapRatio(0.05), criticalNetRatio(0.02), numCluster(0), numConductorPerNet(8), seed(1) {}
+
+void Generator::scale(double factor)
+{
+    double sideFactor = std::sqrt(factor);
+    auto scaleSide = [&](int64_t side) -> int64_t
+    {
+        int64_t numWindow = std::llround(sideFactor * side / windowSize);
+        return std::max<int64_t>(numWindow, 1) * windowSize;
+    };
+    chipWidth = scaleSide(chipWidth);
+    chipHeight = scaleSide(chipHeight);
+    numConductor = std::llround(factor * numConductor);
+}
+
+bool Generator::generate(const std::string &filepath)
+{
+    if (windowSize <= 0 || chipWidth <= 0 || chipHeight <= 0 || chipWidth % windowSize != 0 || chipHeight % windowSize != 0)
+    {
+        std::cerr << "[Error] The chip sides must be positive multiples of the window size.\n";
+        return false;
+    }
+    if (numLayer == 0 || numConductorPerNet == 0)
+    {
+        std::cerr << "[Error] There must be at least one layer and one conductor per net.\n";
+        return false;
+    }
+
+    std::ofstream fout(filepath);
+    if (!fout)
+    {
+        std::cerr << "[Error] Cannot open \"" << filepath << "\".\n";
+        return false;
+    }
+
+    engine.seed(seed);
+    std::vector<raw::Layer> layers = getLayers();
+    int64_t numNet = std::max<int64_t>(numConductor / numConductorPerNet, 1);
+    std::vector<int64_t> criticalNets = getCriticalNets(numNet);
+
+    // spread the horizontal layers evenly over the stack
+    std::vector<bool> isHorizontalLayer(numLayer);
+    for (size_t layerIdx = 0; layerIdx < numLayer; ++layerIdx)
+        isHorizontalLayer[layerIdx] = std::floor((layerIdx + 1) * horizontalRatio) > std::floor(layerIdx * horizontalRatio);
+
+    std::vector<std::pair<double, double>> clusterCenters(numCluster);
+    for (auto &[x, y] : clusterCenters)
+    {
+        x = getReal() * chipWidth;
+        y = getReal() * chipHeight;
+    }
+    double clusterSigma = std::min(chipWidth, chipHeight) / 16.0;
+
+    fout << 0 << " " << 0 << " " << chipWidth << " " << chipHeight << " " << windowSize << "\n"
+         << criticalNets.size() << " " << numLayer << " " << numConductor << "\n";
+    for (int64_t netId : criticalNets)
+        fout << netId << "\n";
+    for (const raw::Layer &layer : layers)
+        fout << layer.id << " " << layer.minFillWidth << " " << layer.minSpacing << " " << layer.maxFillWidth << " "
+             << layer.minMetalDensity << " " << layer.maxMetalDensity << " " << layer.weight << "\n";
+
+    // the conductors are streamed, only the recent ones of each layer are kept for the overlaps
+    std::vector<std::deque<raw::Conductor>> recentConductors(numLayer);
+    raw::Conductor conductor;
+    for (size_t conductorIdx = 0; conductorIdx < numConductor; ++conductorIdx)
+    {
+        size_t layerIdx = getInteger(0, numLayer - 1);
+        const raw::Layer &layer = layers[layerIdx];
+        std::deque<raw::Conductor> &recent = recentConductors[layerIdx];
+        int64_t wireWidth = getInteger(layer.minFillWidth, 2 * layer.minFillWidth);
+        int64_t wireLength = getInteger(4 * layer.minFillWidth, windowSize);
+
+        int64_t x = 0, y = 0;
+        if (!recent.empty() && getReal() < overlapRatio)
+        {
+            const raw::Conductor &overlapped = recent[getInteger(0, recent.size() - 1)];
+            x = getInteger(overlapped.x1, overlapped.x2 - 1);
+            y = getInteger(overlapped.y1, overlapped.y2 - 1);
+            conductor.netId = overlapped.netId;
+        }
+        else
+        {
+            if (numCluster == 0)
+            {
+                x = getInteger(0, chipWidth - 1);
+                y = getInteger(0, chipHeight - 1);
+            }
+            else
+            {
+                const auto &[centerX, centerY] = clusterCenters[getInteger(0, numCluster - 1)];
+                x = std::clamp<int64_t>(std::llround(centerX + getGaussian() * clusterSigma), 0, chipWidth - 1);
+                y = std::clamp<int64_t>(std::llround(centerY + getGaussian() * clusterSigma), 0, chipHeight - 1);
+            }
+            conductor.netId = getInteger(1, numNet);
+        }
+
+        int64_t width = isHorizontalLayer[layerIdx] ? wireLength : wireWidth;
+        int64_t height = isHorizontalLayer[layerIdx] ? wireWidth : wireLength;
+        width = std::min(width, chipWidth);
+        height = std::min(height, chipHeight);
+        conductor.id = conductorIdx + 1;
+        conductor.layerId = layer.id;
+        conductor.x1 = std::min(x, chipWidth - width);
+        conductor.y1 = std::min(y, chipHeight - height);
+        conductor.x2 = conductor.x1 + width;
+        conductor.y2 = conductor.y1 + height;
+        fout << conductor.id << " " << conductor.x1 << " " << conductor.y1 << " " << conductor.x2 << " " << conductor.y2 << " "
+             << conductor.netId << " " << conductor.layerId << "\n";
+
+        recent.emplace_back(conductor);
+        if (recent.size() > numRecentConductor)
+            recent.pop_front();
+    }
+    return static_cast<bool>(fout);
+}
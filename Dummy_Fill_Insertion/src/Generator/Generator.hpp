@@ -0,0 +1,43 @@
+#pragma once
+#include "../Structure/Raw/Raw.hpp"
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+// Synthetic input generator for scaling tests. The output is in the input
+// format of the Parser and only depends on the options and the seed: the
+// random numbers are drawn from std::mt19937_64 directly, whose sequence is
+// fixed by the standard, instead of the library-defined distributions.
+//
+// Conductors are wires along the direction of their layer. A share of them
+// overlaps an earlier wire of the same layer and joins its net. Wires are
+// spread uniformly over the chip, or around Gaussian clusters to create
+// dense and sparse windows.
+class Generator
+{
+    static constexpr size_t numRecentConductor = 256; // per layer, candidates of an overlapping wire
+
+    std::mt19937_64 engine;
+
+    int64_t getInteger(int64_t lower, int64_t upper); // in [lower, upper]
+    double getReal();                                 // in [0, 1)
+    double getGaussian();
+    std::vector<raw::Layer> getLayers() const;
+    std::vector<int64_t> getCriticalNets(int64_t numNet);
+
+public:
+    int64_t chipWidth, chipHeight, windowSize;
+    size_t numLayer, numConductor;
+    double horizontalRatio;    // share of the layers with horizontal wires
+    double overlapRatio;       // share of the wires overlapping an earlier one
+    double criticalNetRatio;   // share of the nets being critical
+    size_t numCluster;         // 0 for uniform density
+    size_t numConductorPerNet; // on average
+    uint64_t seed;
+
+    Generator();
+    // the chip area and the number of conductors grow by the factor, the chip sides are whole windows
+    void scale(double factor);
+    bool generate(const std::string &filepath);
+};
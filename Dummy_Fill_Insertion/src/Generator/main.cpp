@@ -0,0 +1,70 @@
+#include "Generator.hpp"
+#include <cstdlib>
+#include <iostream>
+#include <unistd.h>
+
+int main(int argc, char *argv[])
+{
+    Generator generator;
+    double factor = 1;
+    int opt;
+    while ((opt = getopt(argc, argv, "hx:y:w:l:c:d:o:k:g:n:f:s:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'x':
+            generator.chipWidth = std::atoll(optarg);
+            break;
+        case 'y':
+            generator.chipHeight = std::atoll(optarg);
+            break;
+        case 'w':
+            generator.windowSize = std::atoll(optarg);
+            break;
+        case 'l':
+            generator.numLayer = std::atoi(optarg);
+            break;
+        case 'c':
+            generator.numConductor = std::atoll(optarg);
+            break;
+        case 'd':
+            generator.horizontalRatio = std::atof(optarg);
+            break;
+        case 'o':
+            generator.overlapRatio = std::atof(optarg);
+            break;
+        case 'k':
+            generator.criticalNetRatio = std::atof(optarg);
+            break;
+        case 'g':
+            generator.numCluster = std::atoi(optarg);
+            break;
+        case 'n':
+            generator.numConductorPerNet = std::atoi(optarg);
+            break;
+        case 'f':
+            factor = std::atof(optarg);
+            break;
+        case 's':
+            generator.seed = std::strtoull(optarg, nullptr, 10);
+            break;
+        default:
+            optind = argc + 1;
+            break;
+        }
+    }
+    if (argc - optind != 1 || factor <= 0)
+    {
+        std::cerr << "Usage: " << argv[0] << " [-x <chip width>] [-y <chip height>] [-w <window size>] [-l <#layers>] [-c <#conductors>]"
+                  << " [-d <horizontal layer ratio>] [-o <overlap ratio>] [-k <critical net ratio>] [-g <#clusters | 0 for uniform>]"
+                  << " [-n <#conductors per net>] [-f <scale factor>] [-s <seed>] <output file>\n";
+        return 1;
+    }
+
+    generator.scale(factor);
+    if (!generator.generate(argv[optind]))
+        return 1;
+    std::cout << "Chip size:    " << generator.chipWidth << " " << generator.chipHeight << "\n"
+              << "#conductors:  " << generator.numConductor << "\n";
+    return 0;
+}
@@ -0,0 +1,26 @@
+#ifdef COUNT_ALLOCATION
+#include "MemoryTracker.hpp"
+#include <cstdlib>
+#include <new>
+
+// Replacements of the global operator new and delete that count every heap
+// allocation of the program, enabled with `make COUNT_ALLOCATION=1`. The
+// array and nothrow forms call these ones.
+void *operator new(std::size_t size)
+{
+    MemoryTracker::getAllocationCounter().fetch_add(1, std::memory_order_relaxed);
+    if (void *ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+#endif
@@ -0,0 +1,100 @@
+#include "MemoryReport.hpp"
+#include "MemoryTracker.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+std::vector<MemoryReport::Usage> MemoryReport::usages;
+std::vector<MemoryReport::Snapshot> MemoryReport::snapshots;
+
+size_t MemoryReport::Snapshot::getNumByte() const
+{
+    size_t numByte = 0;
+    for (const Usage &usage : usages)
+        numByte += usage.numByte;
+    return numByte;
+}
+
+void MemoryReport::record(const std::string &owner, const std::string &structure, size_t numObject, size_t numByte)
+{
+    auto it = std::find_if(usages.begin(), usages.end(), [&](const Usage &usage) -> bool
+                           { return usage.owner == owner && usage.structure == structure; });
+    if (it != usages.end())
+    {
+        it->numObject = numObject;
+        it->numByte = numByte;
+    }
+    else
+        usages.push_back(Usage{owner, structure, numObject, numByte});
+}
+
+void MemoryReport::release(const std::string &owner)
+{
+    usages.erase(std::remove_if(usages.begin(), usages.end(), [&](const Usage &usage) -> bool
+                                { return usage.owner == owner; }),
+                 usages.end());
+}
+
+const MemoryReport::Snapshot &MemoryReport::takeSnapshot(const std::string &phase, int64_t layerId)
+{
+    snapshots.push_back(Snapshot{phase, layerId, MemoryTracker::getCurrentMemory(), MemoryTracker::getPeakMemory(), usages});
+    return snapshots.back();
+}
+
+void MemoryReport::printPeak(std::ostream &output)
+{
+    if (snapshots.empty())
+        return;
+    const Snapshot &peak = *std::max_element(snapshots.begin(), snapshots.end(), [](const Snapshot &a, const Snapshot &b) -> bool
+                                             { return a.getNumByte() < b.getNumByte(); });
+
+    char line[128];
+    output << "----- MEMORY -----\n"
+           << "Peak of tracked structures:           " << peak.phase;
+    if (peak.layerId != noLayer)
+        output << " (layer " << peak.layerId << ")";
+    output << "\n";
+    std::snprintf(line, sizeof(line), "%-38s%14s%12s\n", "structure", "#objects", "MB");
+    output << line;
+    for (const Usage &usage : peak.usages)
+    {
+        std::string name = usage.owner + "::" + usage.structure;
+        std::snprintf(line, sizeof(line), "%-38s%14zu%12.2lf\n", name.c_str(), usage.numObject, usage.numByte / 1048576.0);
+        output << line;
+    }
+    std::snprintf(line, sizeof(line), "%-38s%14s%12.2lf\n", "total", "", peak.getNumByte() / 1048576.0);
+    output << line
+           << "\n";
+}
+
+bool MemoryReport::writeJson(const std::string &filepath)
+{
+    std::ofstream fout(filepath);
+    if (!fout)
+    {
+        std::cerr << "[Error] Cannot open \"" << filepath << "\".\n";
+        return false;
+    }
+
+    fout << "{\"snapshots\": [";
+    for (size_t i = 0; i < snapshots.size(); ++i)
+    {
+        const Snapshot &snapshot = snapshots[i];
+        fout << (i ? "," : "") << "\n  {\"phase\": \"" << snapshot.phase << "\", \"layer\": ";
+        if (snapshot.layerId != noLayer)
+            fout << snapshot.layerId;
+        else
+            fout << "null";
+        fout << ", \"rssKB\": " << snapshot.currentMemory << ", \"peakRssKB\": " << snapshot.peakMemory << ", \"structures\": [";
+        for (size_t j = 0; j < snapshot.usages.size(); ++j)
+        {
+            const Usage &usage = snapshot.usages[j];
+            fout << (j ? ", " : "") << "{\"owner\": \"" << usage.owner << "\", \"name\": \"" << usage.structure
+                 << "\", \"objects\": " << usage.numObject << ", \"bytes\": " << usage.numByte << "}";
+        }
+        fout << "]}";
+    }
+    fout << "\n]}\n";
+    return static_cast<bool>(fout);
+}
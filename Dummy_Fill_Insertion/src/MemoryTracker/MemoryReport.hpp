@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// Bytes and object counts of the large data structures, recorded by their
+// owners and collected with the resident set size at the phase boundaries.
+// The bytes are estimated from the container capacities and the node sizes
+// of the standard library, the allocator overhead is not included.
+class MemoryReport
+{
+public:
+    static constexpr int64_t noLayer = INT64_MIN;
+
+    struct Usage
+    {
+        std::string owner, structure;
+        size_t numObject, numByte;
+    };
+
+    struct Snapshot
+    {
+        std::string phase;
+        int64_t layerId;
+        size_t currentMemory, peakMemory; // resident set size in KB
+        std::vector<Usage> usages;
+
+        size_t getNumByte() const;
+    };
+
+private:
+    static std::vector<Usage> usages; // current, one per (owner, structure)
+    static std::vector<Snapshot> snapshots;
+
+public:
+    template <typename T>
+    static size_t getNumByte(const std::vector<T> &values)
+    {
+        return values.capacity() * sizeof(T);
+    }
+    template <typename T>
+    static size_t getNumByte(const std::vector<std::unique_ptr<T>> &values)
+    {
+        return values.capacity() * sizeof(std::unique_ptr<T>) + values.size() * sizeof(T);
+    }
+    static size_t getNumByte(const std::vector<bool> &values)
+    {
+        return (values.capacity() + 7) / 8;
+    }
+    template <typename T>
+    static size_t getNumByte(const std::deque<T> &values)
+    {
+        return values.size() * sizeof(T);
+    }
+    template <typename T>
+    static size_t getNumByte(const std::unordered_set<T> &values)
+    {
+        return values.bucket_count() * sizeof(void *) + values.size() * (sizeof(void *) + sizeof(T));
+    }
+
+    // replace the usage of a structure, the owner is released when it is destroyed
+    static void record(const std::string &owner, const std::string &structure, size_t numObject, size_t numByte);
+    static void release(const std::string &owner);
+    static const Snapshot &takeSnapshot(const std::string &phase, int64_t layerId = noLayer);
+    // the structures at the snapshot with the most tracked bytes
+    static void printPeak(std::ostream &output);
+    static bool writeJson(const std::string &filepath);
+};
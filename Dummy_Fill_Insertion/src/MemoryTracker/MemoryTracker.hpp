@@ -0,0 +1,59 @@
+#pragma once
+#include <atomic>
+#include <fstream>
+#include <string>
+
+class MemoryTracker
+{
+public:
+    // a field of /proc/self/status in KB, 0 if unavailable
+    static size_t getStatusField(const std::string &field)
+    {
+        std::ifstream fin("/proc/self/status");
+        std::string buff;
+        while (fin >> buff)
+        {
+            if (buff == field)
+            {
+                size_t memory = 0;
+                fin >> memory;
+                return memory;
+            }
+        }
+        return 0;
+    }
+
+    // peak resident set size in KB, 0 if unavailable
+    static size_t getPeakMemory()
+    {
+        return getStatusField("VmHWM:");
+    }
+
+    // current resident set size in KB, 0 if unavailable
+    static size_t getCurrentMemory()
+    {
+        return getStatusField("VmRSS:");
+    }
+
+    // counter of the heap allocations, increased by the global operator new when built with COUNT_ALLOCATION
+    static std::atomic<size_t> &getAllocationCounter()
+    {
+        static std::atomic<size_t> numAllocation(0);
+        return numAllocation;
+    }
+
+    static bool isCountingAllocation()
+    {
+#ifdef COUNT_ALLOCATION
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // number of heap allocations so far, 0 unless built with COUNT_ALLOCATION
+    static size_t getNumAllocation()
+    {
+        return getAllocationCounter().load(std::memory_order_relaxed);
+    }
+};
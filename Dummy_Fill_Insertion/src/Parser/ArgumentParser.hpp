@@ -1,36 +1,229 @@
 #pragma once
+#include <cerrno>
+#include <cstdlib>
+#include <getopt.h>
 #include <iostream>
+#include <limits>
 #include <string>
 #include <unistd.h>
 
 class ArgumentParser
 {
+    void printUsage(const char *program) const
+    {
+        std::cerr << "Usage: " << program << " [-l <time limit>] [-n <#tiles per window side | auto>] [-f <previous output file> -d <conductor delta file>] [-s <#windows per stripe> | -p <#workers> | -j <#threads>] [-t <trace file>] [-c] [-m <memory report file>] [--self-check] [--progress <seconds>] [--status <status file>] [--raster <image file prefix> [--raster-resolution <units per pixel>] [--raster-coverage]] <input file> <output file>\n";
+    }
+
+    // a whole positive number up to maxValue, so that a sign, a trailing character or an overflow is rejected
+    static bool parseCount(const char *str, size_t maxValue, size_t &value)
+    {
+        char *end = nullptr;
+        errno = 0;
+        long long parsed = std::strtoll(str, &end, 10);
+        if (errno != 0 || end == str || *end != '\0' || parsed <= 0 || static_cast<unsigned long long>(parsed) > maxValue)
+            return false;
+        value = static_cast<size_t>(parsed);
+        return true;
+    }
+
 public:
+    static constexpr size_t maxTimeLimit = std::numeric_limits<int>::max();
+    static constexpr size_t maxNumTileForWindow = 1 << 20;
+    static constexpr size_t maxNumWindowPerStripe = 1 << 20;
+    static constexpr size_t maxNumWorker = 1024;
+    static constexpr size_t maxNumThread = 1024;
+
     std::string inputFilepath, outputFilepath;
+    std::string previousOutputFilepath, deltaFilepath; // for incremental (ECO) mode
+    std::string traceFilepath;                          // Chrome trace of the profiler zones, empty for none
+    std::string memoryFilepath;                         // JSON memory report of the phases, empty for none
+    std::string statusFilepath;                         // JSON progress status rewritten while solving, empty for none
+    std::string rasterPrefix;                           // density heatmap (and coverage) images per layer, empty for none
+    int timeLimit;                                      // in seconds
+    size_t numTileForWindow;                            // 0 for choosing automatically
+    size_t numWindowPerStripe;                          // 0 for solving the whole chip in memory
+    size_t numWorker;                                   // 0 for solving in this process only
+    size_t numThread;                                   // 1 for solving in this thread only
+    double progressInterval;                            // in seconds, 0 for no progress lines
+    int64_t rasterResolution;                           // database units per pixel, 0 for choosing automatically
+    bool isCountingHardware;                            // hardware counters per profiler zone
+    bool isSelfCheck;                                   // verify the fillers in-process after solving
+    bool isRasterCoverage;                              // also the conductor and filler coverage images
 
-    ArgumentParser() {}
+    ArgumentParser() : timeLimit(10 * 60 - 10), numTileForWindow(4), numWindowPerStripe(0), numWorker(0), numThread(1), progressInterval(0), rasterResolution(0), isCountingHardware(false), isSelfCheck(false), isRasterCoverage(false) {}
 
     bool parse(int argc, char *argv[])
     {
+        const option longOptions[] = {{"self-check", no_argument, nullptr, 'S'},
+                                      {"progress", required_argument, nullptr, 'P'},
+                                      {"status", required_argument, nullptr, 'T'},
+                                      {"raster", required_argument, nullptr, 'R'},
+                                      {"raster-resolution", required_argument, nullptr, 'U'},
+                                      {"raster-coverage", no_argument, nullptr, 'C'},
+                                      {nullptr, 0, nullptr, 0}};
         int opt;
-        while ((opt = getopt(argc, argv, "h")) != -1)
+        while ((opt = getopt_long(argc, argv, "hl:n:f:d:s:p:j:t:cm:", longOptions, nullptr)) != -1)
         {
             switch (opt)
             {
+            case 'l':
+            {
+                size_t numSecond = 0;
+                if (!parseCount(optarg, maxTimeLimit, numSecond))
+                {
+                    printUsage(argv[0]);
+                    return false;
+                }
+                timeLimit = static_cast<int>(numSecond);
+                break;
+            }
+            case 'n':
+                if (std::string(optarg) == "auto")
+                    numTileForWindow = 0;
+                else if (!parseCount(optarg, maxNumTileForWindow, numTileForWindow))
+                {
+                    printUsage(argv[0]);
+                    return false;
+                }
+                break;
+            case 'f':
+                previousOutputFilepath = optarg;
+                break;
+            case 'd':
+                deltaFilepath = optarg;
+                break;
+            case 's':
+                if (!parseCount(optarg, maxNumWindowPerStripe, numWindowPerStripe))
+                {
+                    printUsage(argv[0]);
+                    return false;
+                }
+                if (numWindowPerStripe < 2)
+                {
+                    std::cerr << "[Error] A stripe must span at least 2 window rows.\n";
+                    return false;
+                }
+                break;
+            case 'p':
+                if (!parseCount(optarg, maxNumWorker, numWorker))
+                {
+                    printUsage(argv[0]);
+                    return false;
+                }
+                break;
+            case 'j':
+                if (!parseCount(optarg, maxNumThread, numThread))
+                {
+                    printUsage(argv[0]);
+                    return false;
+                }
+                break;
+            case 't':
+                traceFilepath = optarg;
+                break;
+            case 'c':
+                isCountingHardware = true;
+                break;
+            case 'm':
+                memoryFilepath = optarg;
+                break;
+            case 'S':
+                isSelfCheck = true;
+                break;
+            case 'P':
+                progressInterval = std::atof(optarg);
+                if (progressInterval <= 0)
+                {
+                    printUsage(argv[0]);
+                    return false;
+                }
+                break;
+            case 'T':
+                statusFilepath = optarg;
+                break;
+            case 'R':
+                rasterPrefix = optarg;
+                break;
+            case 'U':
+                rasterResolution = std::atoll(optarg);
+                if (rasterResolution <= 0)
+                {
+                    printUsage(argv[0]);
+                    return false;
+                }
+                break;
+            case 'C':
+                isRasterCoverage = true;
+                break;
             default:
-                std::cerr << "Usage: " << argv[0] << " <input file> <output file>\n";
+                printUsage(argv[0]);
                 return false;
                 break;
             }
         }
 
-        if (argc - optind != 2)
+        if (argc - optind != 2 || timeLimit <= 0 || previousOutputFilepath.empty() != deltaFilepath.empty())
+        {
+            printUsage(argv[0]);
+            return false;
+        }
+        if (isStripe() && (isIncremental() || numTileForWindow == 0))
         {
-            std::cerr << "Usage: " << argv[0] << " <input file> <output file>\n";
+            std::cerr << "[Error] Stripe mode needs an explicit #tiles per window side and cannot be combined with the incremental mode.\n";
+            return false;
+        }
+        if (isMultiProcess() && (isIncremental() || isStripe()))
+        {
+            std::cerr << "[Error] Multi-process mode cannot be combined with the incremental or the stripe mode.\n";
+            return false;
+        }
+        if (isMultiThread() && (isStripe() || isMultiProcess()))
+        {
+            std::cerr << "[Error] Multi-thread mode cannot be combined with the stripe or the multi-process mode.\n";
+            return false;
+        }
+        if (isSelfCheck && isStripe())
+        {
+            std::cerr << "[Error] Self-check cannot be combined with the stripe mode, which never holds the whole chip.\n";
+            return false;
+        }
+        if (rasterPrefix.empty() && (rasterResolution > 0 || isRasterCoverage))
+        {
+            printUsage(argv[0]);
+            return false;
+        }
+        if (!rasterPrefix.empty() && (isStripe() || isMultiProcess()))
+        {
+            std::cerr << "[Error] Raster export cannot be combined with the stripe or the multi-process mode, which never hold a whole layer.\n";
             return false;
         }
         inputFilepath = argv[optind];
         outputFilepath = argv[optind + 1];
         return true;
     }
+
+    bool isIncremental() const
+    {
+        return !previousOutputFilepath.empty();
+    }
+
+    bool isStripe() const
+    {
+        return numWindowPerStripe > 0;
+    }
+
+    bool isMultiProcess() const
+    {
+        return numWorker > 0;
+    }
+
+    bool isMultiThread() const
+    {
+        return numThread > 1;
+    }
+
+    bool isReportingProgress() const
+    {
+        return progressInterval > 0 || !statusFilepath.empty();
+    }
 };
@@ -1,4 +1,5 @@
 #include "Parser.hpp"
+#include "../MemoryTracker/MemoryReport.hpp"
 #include <algorithm>
 #include <fstream>
 #include <iostream>
@@ -71,7 +72,125 @@ void Parser::readConductor(std::istream &input)
         buffStream >> conductor->x1 >> conductor->y1 >> conductor->x2 >> conductor->y2;
         buffStream >> conductor->netId >> conductor->layerId;
         conductors.emplace_back(conductor);
+
+        std::pair<double, size_t> &aspectRatio = layerToAspectRatio[conductor->layerId];
+        aspectRatio.first += conductor->aspectRatio();
+        ++aspectRatio.second;
+    }
+}
+
+void Parser::streamConductor(std::istream &input, StripeStore &stripeStore)
+{
+    raw::Conductor conductor;
+    for (size_t i = 0; i < numConductor; ++i)
+    {
+        std::string buff;
+        std::getline(input, buff);
+        std::stringstream buffStream(buff);
+
+        buffStream >> conductor.id;
+        buffStream >> conductor.x1 >> conductor.y1 >> conductor.x2 >> conductor.y2;
+        buffStream >> conductor.netId >> conductor.layerId;
+
+        // the layer direction is decided from the whole chip, not per region
+        std::pair<double, size_t> &aspectRatio = layerToAspectRatio[conductor.layerId];
+        aspectRatio.first += conductor.aspectRatio();
+        ++aspectRatio.second;
+        stripeStore.addConductor(conductor);
+    }
+}
+
+bool Parser::readDelta(std::istream &input)
+{
+    std::unordered_map<int64_t, size_t> idToIdx;
+    for (size_t i = 0; i < conductors.size(); ++i)
+        idToIdx.emplace(conductors[i]->id, i);
+    std::unordered_set<int64_t> layerIds;
+    for (const raw::Layer::ptr &layer : layers)
+        layerIds.insert(layer->id);
+
+    std::string buff;
+    while (std::getline(input, buff))
+    {
+        std::stringstream buffStream(buff);
+        char operation;
+        if (!(buffStream >> operation))
+            continue;
+
+        if (operation == '+')
+        {
+            raw::Conductor::ptr conductor(new raw::Conductor());
+            buffStream >> conductor->id;
+            buffStream >> conductor->x1 >> conductor->y1 >> conductor->x2 >> conductor->y2;
+            buffStream >> conductor->netId >> conductor->layerId;
+            if (!buffStream)
+            {
+                std::cerr << "[Error] Cannot add conductor from \"" << buff << "\". Malformed delta line.\n";
+                return false;
+            }
+            if (!layerIds.count(conductor->layerId))
+            {
+                std::cerr << "[Error] Cannot add conductor " << conductor->id << ". Layer " << conductor->layerId << " does not exist.\n";
+                return false;
+            }
+            if (!idToIdx.emplace(conductor->id, conductors.size()).second)
+            {
+                std::cerr << "[Error] Cannot add conductor " << conductor->id << ". Conductor already exists.\n";
+                return false;
+            }
+            changedConductors.emplace_back(new raw::Conductor(*conductor));
+            conductors.emplace_back(std::move(conductor));
+        }
+        else if (operation == '-')
+        {
+            int64_t id;
+            if (!(buffStream >> id))
+            {
+                std::cerr << "[Error] Cannot remove conductor from \"" << buff << "\". Malformed delta line.\n";
+                return false;
+            }
+            auto it = idToIdx.find(id);
+            if (it == idToIdx.end())
+            {
+                std::cerr << "[Error] Cannot remove conductor " << id << ". Conductor does not exist.\n";
+                return false;
+            }
+            changedConductors.emplace_back(conductors[it->second].release());
+            idToIdx.erase(it);
+        }
+        else
+        {
+            std::cerr << "[Error] Unknown delta operation \"" << operation << "\".\n";
+            return false;
+        }
     }
+
+    conductors.erase(std::remove(conductors.begin(), conductors.end(), nullptr), conductors.end());
+    numConductor = conductors.size();
+    return true;
+}
+
+bool Parser::readFiller(std::istream &input)
+{
+    std::string buff;
+    while (std::getline(input, buff))
+    {
+        std::stringstream buffStream(buff);
+        raw::Filler *filler = new raw::Filler();
+        if (buffStream >> filler->x1 >> filler->y1 >> filler->x2 >> filler->y2 >> filler->layerId)
+        {
+            fillers.emplace_back(filler);
+            continue;
+        }
+
+        delete filler;
+        if (buff.find_first_not_of(" \t\r") != std::string::npos)
+        {
+            std::cerr << "[Error] Cannot read filler from \"" << buff << "\". Malformed line.\n";
+            return false;
+        }
+    }
+    return !input.bad();
 }
 
 void Parser::writeChipInfo(std::ostream &output) const
@@ -109,6 +228,12 @@ void Parser::writeConductor(std::ostream &output) const
 
 Parser::Parser() : numCriticalNet(0), numLayer(0), numConductor(0) {}
 
+Parser::~Parser()
+{
+    MemoryReport::release("Parser");
+    MemoryReport::release("Database");
+}
+
 bool Parser::parse(const std::string &filepath)
 {
     std::ifstream fin(filepath);
@@ -119,11 +244,57 @@ bool Parser::parse(const std::string &filepath)
     }
 
     readChipInfo(fin);
+    if (chipBoundary.width() > maxChipSize || chipBoundary.height() > maxChipSize)
+    {
+        std::cerr << "[Error] Design size exceeds " << maxChipSize << ", which the 32-bit solver coordinates cannot hold.\n";
+        return false;
+    }
     readNum(fin);
     readCriticalNet(fin);
     readLayer(fin);
     readConductor(fin);
 
+    printDesignInformation();
+    return true;
+}
+
+bool Parser::parse(const std::string &filepath, StripeStore &stripeStore)
+{
+    std::ifstream fin(filepath);
+    if (!fin.is_open())
+    {
+        std::cerr << "[Error] Cannot open \"" << filepath << "\".\n";
+        return false;
+    }
+
+    readChipInfo(fin);
+    if (chipBoundary.width() > maxChipSize)
+    {
+        std::cerr << "[Error] Design width exceeds " << maxChipSize << ", which the 32-bit solver coordinates cannot hold.\n";
+        return false;
+    }
+    readNum(fin);
+    readCriticalNet(fin);
+    readLayer(fin);
+    int64_t maxFillWidth = 0;
+    for (const raw::Layer::ptr &layer : layers)
+        maxFillWidth = std::max(maxFillWidth, layer->maxFillWidth);
+    if (!stripeStore.open(chipBoundary, windowSize, maxFillWidth))
+        return false;
+    streamConductor(fin, stripeStore);
+    if (!stripeStore.close())
+        return false;
+
+    printDesignInformation();
+    std::cout << "----- STRIPE INFORMATION -----\n"
+              << "#stripes:              " << stripeStore.getNumStripe() << "\n"
+              << "#stored conductors:    " << stripeStore.getNumStoredConductor() << "\n"
+              << "\n";
+    return true;
+}
+
+void Parser::printDesignInformation() const
+{
     std::cout << "----- DESIGN INFORMATION -----\n"
               << "Design width:   " << chipBoundary.x2 - chipBoundary.x1 << "\n"
               << "Design height:  " << chipBoundary.y2 - chipBoundary.y1 << "\n"
@@ -132,6 +303,41 @@ bool Parser::parse(const std::string &filepath)
               << "#conductors:    " << numConductor << "\n"
               << "#critical nets: " << numCriticalNet << "\n"
               << "\n";
+}
+
+bool Parser::parseDelta(const std::string &filepath)
+{
+    std::ifstream fin(filepath);
+    if (!fin.is_open())
+    {
+        std::cerr << "[Error] Cannot open \"" << filepath << "\".\n";
+        return false;
+    }
+
+    if (!readDelta(fin))
+        return false;
+
+    std::cout << "----- CONDUCTOR DELTA -----\n"
+              << "#changed conductors: " << changedConductors.size() << "\n"
+              << "#conductors:         " << numConductor << "\n"
+              << "\n";
+    return true;
+}
+
+bool Parser::parseFiller(const std::string &filepath)
+{
+    std::ifstream fin(filepath);
+    if (!fin.is_open())
+    {
+        std::cerr << "[Error] Cannot open \"" << filepath << "\".\n";
+        return false;
+    }
+
+    if (!readFiller(fin))
+    {
+        std::cerr << "[Error] Cannot read the fillers of \"" << filepath << "\".\n";
+        return false;
+    }
     return true;
 }
 
@@ -155,7 +361,10 @@ bool Parser::write(const std::string &filepath) const
 process::Database::ptr Parser::createDatabase() const
 {
     process::Database *database = new process::Database();
-    database->chipBoundary = chipBoundary;
+    database->originX = chipBoundary.x1;
+    database->originY = chipBoundary.y1;
+    database->chipBoundary = database->toRelative(chipBoundary);
+    database->windowBoundary = database->chipBoundary;
     database->windowSize = windowSize;
 
     std::unordered_map<int64_t, process::Layer *> idToLayer;
@@ -167,19 +376,27 @@ process::Database::ptr Parser::createDatabase() const
     }
 
     std::unordered_set<int64_t> criticalNetSet(criticalNets.begin(), criticalNets.end());
+    std::unordered_map<int64_t, size_t> idToNumConductor;
     for (const raw::Conductor::ptr &conductor : conductors)
-    {
-        process::Conductor *newConductor = new process::Conductor(conductor.get());
-        idToLayer[conductor->layerId]->conductors.emplace_back(newConductor);
-        if (criticalNetSet.count(conductor->netId))
-            newConductor->isCritical = true;
-    }
+        ++idToNumConductor[conductor->layerId];
+    for (const auto &[layerId, numLayerConductor] : idToNumConductor)
+        idToLayer[layerId]->conductors.reserve(numLayerConductor);
+    for (const raw::Conductor::ptr &conductor : conductors)
+        idToLayer[conductor->layerId]->conductors.emplace_back(database->toRelative(*conductor), conductor->netId,
+                                                               criticalNetSet.count(conductor->netId));
+
+    for (const raw::Conductor::ptr &conductor : changedConductors)
+        if (idToLayer.count(conductor->layerId))
+            idToLayer[conductor->layerId]->changedRegions.emplace_back(database->toRelative(*conductor));
+    for (const raw::Filler::ptr &filler : fillers)
+        if (idToLayer.count(filler->layerId))
+            idToLayer[filler->layerId]->previousFillers.emplace_back(database->toRelative(*filler));
 
     for (process::Layer::ptr &layer : database->layers)
     {
         double aspectRatio = 0;
-        for (const process::Conductor::ptr &conductor : layer->conductors)
-            aspectRatio += conductor->aspectRatio();
+        for (size_t i = 0; i < layer->conductors.size(); ++i)
+            aspectRatio += layer->conductors[i].aspectRatio();
         aspectRatio /= layer->conductors.size();
         if (aspectRatio >= 1)
             layer->direction = process::Layer::Direction::HORIZONTAL;
@@ -188,3 +405,67 @@ process::Database::ptr Parser::createDatabase() const
     }
     return std::unique_ptr<process::Database>(database);
 }
+
+process::Database::ptr Parser::createDatabase(const geometry::Rectangle &region, const std::vector<raw::Conductor::ptr> &regionConductors) const
+{
+    process::Database *database = new process::Database();
+    database->originX = region.x1;
+    database->originY = region.y1;
+    database->chipBoundary = database->toRelative(region);
+    database->windowBoundary = database->chipBoundary;
+    database->windowSize = windowSize;
+
+    std::unordered_map<int64_t, process::Layer *> idToLayer;
+    for (const raw::Layer::ptr &layer : layers)
+    {
+        process::Layer *newLayer = new process::Layer(*layer.get());
+        auto it = layerToAspectRatio.find(layer->id);
+        if (it != layerToAspectRatio.end() && it->second.first / it->second.second >= 1)
+            newLayer->direction = process::Layer::Direction::HORIZONTAL;
+        else
+            newLayer->direction = process::Layer::Direction::VERTICAL;
+        database->layers.emplace_back(newLayer);
+        idToLayer.emplace(layer->id, newLayer);
+    }
+
+    std::unordered_set<int64_t> criticalNetSet(criticalNets.begin(), criticalNets.end());
+    for (const raw::Conductor::ptr &conductor : regionConductors)
+    {
+        geometry::Rectangle clippedConductor = geometry::getIntersectRegion(region, geometry::Rectangle(*conductor));
+        if (clippedConductor.isLegal() && idToLayer.count(conductor->layerId))
+            idToLayer[conductor->layerId]->conductors.emplace_back(database->toRelative(clippedConductor), conductor->netId,
+                                                                   criticalNetSet.count(conductor->netId));
+    }
+    return std::unique_ptr<process::Database>(database);
+}
+
+process::Database::ptr Parser::createDatabase(const geometry::Rectangle &region) const
+{
+    std::vector<raw::Conductor::ptr> regionConductors;
+    for (const raw::Conductor::ptr &conductor : conductors)
+        if (geometry::isIntersect<int64_t>(region, *conductor))
+            regionConductors.emplace_back(new raw::Conductor(*conductor));
+    return createDatabase(region, regionConductors);
+}
+
+void Parser::recordMemory(const process::Database *db) const
+{
+    MemoryReport::record("Parser", "conductors", conductors.size(), MemoryReport::getNumByte(conductors));
+    MemoryReport::record("Parser", "changedConductors", changedConductors.size(), MemoryReport::getNumByte(changedConductors));
+    MemoryReport::record("Parser", "fillers", fillers.size(), MemoryReport::getNumByte(fillers));
+    if (!db)
+        return;
+
+    size_t numConductor = 0, numConductorByte = 0, numFiller = 0, numFillerByte = 0;
+    for (const process::Layer::ptr &layer : db->layers)
+    {
+        const process::ConductorStore &store = layer->conductors;
+        numConductor += store.size();
+        numConductorByte += MemoryReport::getNumByte(store.x1s) + MemoryReport::getNumByte(store.y1s) + MemoryReport::getNumByte(store.x2s) +
+                            MemoryReport::getNumByte(store.y2s) + MemoryReport::getNumByte(store.netIds) + MemoryReport::getNumByte(store.isCriticals);
+        numFiller += layer->previousFillers.size() + layer->changedRegions.size();
+        numFillerByte += MemoryReport::getNumByte(layer->previousFillers) + MemoryReport::getNumByte(layer->changedRegions);
+    }
+    MemoryReport::record("Database", "conductors", numConductor, numConductorByte);
+    MemoryReport::record("Database", "previousFillers", numFiller, numFillerByte);
+}
@@ -2,24 +2,38 @@
 #include "../Structure/Geometry/Geometry.hpp"
 #include "../Structure/Process/Process.hpp"
 #include "../Structure/Raw/Raw.hpp"
+#include "../StripeSolver/StripeStore.hpp"
 #include <istream>
 #include <ostream>
+#include <unordered_map>
 #include <vector>
 
 class Parser
 {
+    // the solver works on 32-bit chip-relative coordinates, keep a margin for
+    // the spacing expansion and the coordinate differences
+    static constexpr int64_t maxChipSize = int64_t(1) << 30;
+
     geometry::Rectangle chipBoundary;
     int64_t windowSize;
     size_t numCriticalNet, numLayer, numConductor;
     std::vector<int64_t> criticalNets;
     std::vector<raw::Layer::ptr> layers;
     std::vector<raw::Conductor::ptr> conductors;
+    std::vector<raw::Conductor::ptr> changedConductors;
+    std::vector<raw::Filler::ptr> fillers;
+    std::unordered_map<int64_t, std::pair<double, size_t>> layerToAspectRatio; // (sum, #conductors) of all conductors
 
     void readChipInfo(std::istream &input);
     void readNum(std::istream &input);
     void readCriticalNet(std::istream &input);
     void readLayer(std::istream &input);
     void readConductor(std::istream &input);
+    void streamConductor(std::istream &input, StripeStore &stripeStore);
+    bool readDelta(std::istream &input);
+    bool readFiller(std::istream &input);
+
+    void printDesignInformation() const;
 
     void writeChipInfo(std::ostream &output) const;
     void writeNum(std::ostream &output) const;
@@ -29,7 +43,17 @@ class Parser
 
 public:
     Parser();
+    ~Parser();
     bool parse(const std::string &filepath);
+    // out-of-core mode: the conductors are handed to the stripe store instead of being kept
+    bool parse(const std::string &filepath, StripeStore &stripeStore);
+    bool parseDelta(const std::string &filepath);
+    bool parseFiller(const std::string &filepath);
     bool write(const std::string &filepath) const;
     process::Database::ptr createDatabase() const;
+    // database of one region of the chip from the conductors loaded for it, the conductors are clipped to the region
+    process::Database::ptr createDatabase(const geometry::Rectangle &region, const std::vector<raw::Conductor::ptr> &regionConductors) const;
+    process::Database::ptr createDatabase(const geometry::Rectangle &region) const;
+    // record the raw storage and the conductors of a database in the memory report
+    void recordMemory(const process::Database *db = nullptr) const;
 };
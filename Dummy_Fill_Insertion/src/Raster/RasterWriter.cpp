@@ -0,0 +1,133 @@
+#include "RasterWriter.hpp"
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+RasterWriter::RasterWriter(const geometry::CompactRectangle &boundary_, int64_t resolution_, size_t numThread_)
+    : boundary(boundary_), resolution(std::max<int64_t>(resolution_, 1)), numThread(std::max<size_t>(numThread_, 1)),
+      width((boundary_.width() + resolution - 1) / resolution), height((boundary_.height() + resolution - 1) / resolution) {}
+
+int64_t RasterWriter::getAutoResolution(const geometry::CompactRectangle &boundary)
+{
+    int64_t length = std::max(boundary.width(), boundary.height());
+    return std::max<int64_t>((length + defaultNumPixel - 1) / defaultNumPixel, 1);
+}
+
+std::vector<int64_t> RasterWriter::getCoverage(const std::vector<geometry::CompactRectangle> &rectangles) const
+{
+    std::vector<int64_t> pixels(width * height, 0);
+    auto run = [&](size_t threadIdx)
+    {
+        // pixel rows [beginRow, endRow) are written by this thread only
+        size_t beginRow = threadIdx * height / numThread;
+        size_t endRow = (threadIdx + 1) * height / numThread;
+        int64_t bandY1 = boundary.y1 + static_cast<int64_t>(beginRow) * resolution;
+        int64_t bandY2 = std::min<int64_t>(boundary.y1 + static_cast<int64_t>(endRow) * resolution, boundary.y2);
+        for (const geometry::CompactRectangle &rectangle : rectangles)
+        {
+            int64_t x1 = std::max<int64_t>(rectangle.x1, boundary.x1), x2 = std::min<int64_t>(rectangle.x2, boundary.x2);
+            int64_t y1 = std::max<int64_t>(rectangle.y1, bandY1), y2 = std::min<int64_t>(rectangle.y2, bandY2);
+            if (x1 >= x2 || y1 >= y2)
+                continue;
+
+            size_t beginCol = (x1 - boundary.x1) / resolution, lastCol = (x2 - 1 - boundary.x1) / resolution;
+            int64_t leftLength = boundary.x1 + static_cast<int64_t>(beginCol + 1) * resolution - x1;
+            int64_t rightLength = x2 - (boundary.x1 + static_cast<int64_t>(lastCol) * resolution);
+            for (size_t row = (y1 - boundary.y1) / resolution; row <= static_cast<size_t>((y2 - 1 - boundary.y1) / resolution); ++row)
+            {
+                int64_t rowY1 = boundary.y1 + static_cast<int64_t>(row) * resolution;
+                int64_t coveredHeight = std::min(y2, rowY1 + resolution) - std::max(y1, rowY1);
+                int64_t *rowPixels = pixels.data() + row * width;
+                if (beginCol == lastCol)
+                {
+                    rowPixels[beginCol] += coveredHeight * (x2 - x1);
+                    continue;
+                }
+                rowPixels[beginCol] += coveredHeight * leftLength;
+                int64_t fullArea = coveredHeight * resolution;
+                for (size_t col = beginCol + 1; col < lastCol; ++col)
+                    rowPixels[col] += fullArea;
+                rowPixels[lastCol] += coveredHeight * rightLength;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t threadIdx = 1; threadIdx < numThread; ++threadIdx)
+        threads.emplace_back(run, threadIdx);
+    run(0);
+    for (std::thread &thread : threads)
+        thread.join();
+    return pixels;
+}
+
+bool RasterWriter::writeCoverage(const std::string &filepath, const std::vector<geometry::CompactRectangle> &rectangles) const
+{
+    std::ofstream fout(filepath, std::ios::binary);
+    if (!fout)
+    {
+        std::cerr << "[Error] Cannot open \"" << filepath << "\".\n";
+        return false;
+    }
+
+    std::vector<int64_t> pixels = getCoverage(rectangles);
+    int64_t pixelArea = resolution * resolution;
+    std::vector<unsigned char> line(width);
+    fout << "P5\n"
+         << width << " " << height << "\n255\n";
+    // the image starts at the top row
+    for (size_t row = height; row-- > 0;)
+    {
+        for (size_t col = 0; col < width; ++col)
+            line[col] = static_cast<unsigned char>(std::min<int64_t>(pixels[row * width + col] * 255 / pixelArea, 255));
+        fout.write(reinterpret_cast<const char *>(line.data()), line.size());
+    }
+    return static_cast<bool>(fout);
+}
+
+bool RasterWriter::writeDensityHeatmap(const std::string &filepath, const std::vector<std::vector<double>> &densities,
+                                       double minDensity, double maxDensity, size_t cellSize)
+{
+    std::ofstream fout(filepath, std::ios::binary);
+    if (!fout)
+    {
+        std::cerr << "[Error] Cannot open \"" << filepath << "\".\n";
+        return false;
+    }
+
+    auto getColour = [&](double density) -> std::array<unsigned char, 3>
+    {
+        if (density < minDensity)
+        {
+            double deficit = (minDensity > 0) ? (minDensity - density) / minDensity : 1;
+            return {0, 0, static_cast<unsigned char>(96 + 159 * deficit)};
+        }
+        if (density > maxDensity)
+        {
+            double excess = (maxDensity < 1) ? (density - maxDensity) / (1 - maxDensity) : 1;
+            return {static_cast<unsigned char>(96 + 159 * std::min(excess, 1.0)), 0, 0};
+        }
+        double ratio = (maxDensity > minDensity) ? (density - minDensity) / (maxDensity - minDensity) : 0;
+        return {static_cast<unsigned char>(255 * ratio), static_cast<unsigned char>(128 + 127 * ratio), 0};
+    };
+
+    size_t numRow = densities.size(), numCol = densities.empty() ? 0 : densities.front().size();
+    cellSize = std::max<size_t>(cellSize, 1);
+    std::vector<unsigned char> line(3 * numCol * cellSize);
+    fout << "P6\n"
+         << numCol * cellSize << " " << numRow * cellSize << "\n255\n";
+    for (size_t row = numRow; row-- > 0;)
+    {
+        for (size_t col = 0; col < numCol; ++col)
+        {
+            std::array<unsigned char, 3> colour = getColour(densities[row][col]);
+            for (size_t pixel = col * cellSize; pixel < (col + 1) * cellSize; ++pixel)
+                std::copy(colour.begin(), colour.end(), line.begin() + 3 * pixel);
+        }
+        for (size_t repeat = 0; repeat < cellSize; ++repeat)
+            fout.write(reinterpret_cast<const char *>(line.data()), line.size());
+    }
+    return static_cast<bool>(fout);
+}
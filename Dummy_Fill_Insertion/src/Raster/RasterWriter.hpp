@@ -0,0 +1,35 @@
+#pragma once
+#include "../Structure/Geometry/Geometry.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Full-layer images in the binary Netpbm formats (PGM for gray, PPM for
+// colour), which any image viewer opens. A coverage image gives every pixel
+// the area of the rectangles over it: each thread takes a band of pixel rows
+// and adds every rectangle crossing it as one span per pixel row, with the
+// partial pixels at the ends, so a rectangle costs its rows and not its
+// pixels. A density heatmap gives every window position one cell, coloured
+// by its density against the density constraint.
+class RasterWriter
+{
+    geometry::CompactRectangle boundary;
+    int64_t resolution; // database units per pixel side
+    size_t numThread;
+    size_t width, height; // in pixels
+
+public:
+    static constexpr size_t defaultNumPixel = 2048; // along the longer side for the automatic resolution
+
+    RasterWriter(const geometry::CompactRectangle &boundary_, int64_t resolution_, size_t numThread_);
+    static int64_t getAutoResolution(const geometry::CompactRectangle &boundary);
+    int64_t getResolution() const { return resolution; }
+    // covered area of every pixel, row by row from the bottom; overlapping rectangles are added up
+    std::vector<int64_t> getCoverage(const std::vector<geometry::CompactRectangle> &rectangles) const;
+    // the gray level is the covered fraction of the pixel, white for fully covered
+    bool writeCoverage(const std::string &filepath, const std::vector<geometry::CompactRectangle> &rectangles) const;
+    // densities[row][col] of the window positions from the bottom, cellSize pixels per window position; blue below
+    // minDensity, green to yellow between the constraints and red above maxDensity, darker the closer to the constraint
+    static bool writeDensityHeatmap(const std::string &filepath, const std::vector<std::vector<double>> &densities,
+                                    double minDensity, double maxDensity, size_t cellSize);
+};
@@ -0,0 +1,278 @@
+#include "Regression.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <sys/wait.h>
+
+namespace
+{
+    std::string toShellWord(const std::string &str)
+    {
+        std::string quoted = "'";
+        for (char c : str)
+            quoted += (c == '\'') ? std::string("'\\''") : std::string(1, c);
+        return quoted + "'";
+    }
+
+    std::string toJsonString(const std::string &str)
+    {
+        std::string escaped = "\"";
+        for (char c : str)
+        {
+            if (c == '"' || c == '\\')
+                escaped += '\\';
+            escaped += c;
+        }
+        return escaped + "\"";
+    }
+
+    // just enough JSON for the baseline: nested objects with string keys and number values
+    class JsonReader
+    {
+        std::istream &input;
+
+        bool expect(char c)
+        {
+            input >> std::ws;
+            if (input.peek() != c)
+                return false;
+            input.get();
+            return true;
+        }
+
+        bool readString(std::string &str)
+        {
+            if (!expect('"'))
+                return false;
+            str.clear();
+            for (int c = input.get(); c != '"'; c = input.get())
+            {
+                if (c == EOF)
+                    return false;
+                str += static_cast<char>((c == '\\') ? input.get() : c);
+            }
+            return true;
+        }
+
+    public:
+        JsonReader(std::istream &input_) : input(input_) {}
+
+        // every number by the keys on the way from the root
+        bool readObject(std::vector<std::string> &path, std::map<std::vector<std::string>, double> &pathToNumber)
+        {
+            if (!expect('{'))
+                return false;
+            if (expect('}'))
+                return true;
+            do
+            {
+                std::string key;
+                if (!readString(key) || !expect(':'))
+                    return false;
+                path.emplace_back(key);
+                input >> std::ws;
+                if (input.peek() == '{')
+                {
+                    if (!readObject(path, pathToNumber))
+                        return false;
+                }
+                else if (!(input >> pathToNumber[path]))
+                    return false;
+                path.pop_back();
+            } while (expect(','));
+            return expect('}');
+        }
+    };
+}
+
+Regression::Regression(const std::string &solverFilepath_, const std::string &scratchFilepath_, size_t numRepeat_)
+    : solverFilepath(solverFilepath_), scratchFilepath(scratchFilepath_), numRepeat(std::max<size_t>(numRepeat_, 1)) {}
+
+bool Regression::runOnce(const std::string &inputFilepath, Metrics &metrics) const
+{
+    std::string command = toShellWord(solverFilepath) + " " + toShellWord(inputFilepath) + " " + toShellWord(scratchFilepath) + " 2>&1";
+    FILE *pipe = popen(command.c_str(), "r");
+    if (!pipe)
+    {
+        std::cerr << "[Error] Cannot run \"" << solverFilepath << "\".\n";
+        return false;
+    }
+
+    // the summary lines, the final density of every layer and the phases of the main thread's profile
+    // (depth 1: parsing, processing and writing; depth 3: the passes, summed over the layers)
+    std::string log;
+    char buff[4096];
+    while (fgets(buff, sizeof(buff), pipe))
+        log += buff;
+    int status = pclose(pipe);
+    if (status != 0)
+    {
+        std::cerr << "[Error] \"" << solverFilepath << "\" failed on \"" << inputFilepath << "\" (exit status " << WEXITSTATUS(status) << ").\n";
+        return false;
+    }
+
+    std::stringstream logStream(log);
+    std::string line;
+    bool inProfile = false;
+    double minDensity = 1, maxDensity = 0;
+    while (std::getline(logStream, line))
+    {
+        double first, second;
+        if (line == "----- PROFILE -----")
+        {
+            inProfile = true;
+            std::getline(logStream, line); // header
+        }
+        else if (inProfile && (line.empty() || line[0] == '('))
+            inProfile = false;
+        else if (inProfile)
+        {
+            size_t depth = line.find_first_not_of(' ') / 2;
+            std::stringstream lineStream(line);
+            std::vector<std::string> tokens;
+            for (std::string token; lineStream >> token;)
+                tokens.emplace_back(token);
+            if (tokens.size() < 3 || (depth != 1 && depth != 3))
+                continue;
+            std::string name = tokens[0];
+            for (size_t i = 1; i + 2 < tokens.size(); ++i)
+                name += " " + tokens[i];
+            metrics["phase " + name + " (s)"] += std::stod(tokens[tokens.size() - 2]);
+        }
+        else if (std::sscanf(line.c_str(), "Min/Max density (merge filler): %lf %lf", &first, &second) == 2)
+        {
+            minDensity = std::min(minDensity, first);
+            maxDensity = std::max(maxDensity, second);
+        }
+        else if (std::sscanf(line.c_str(), "runtime: %lf", &first) == 1)
+            metrics["runtime (s)"] = first;
+        else if (std::sscanf(line.c_str(), "peak memory: %lf", &first) == 1)
+            metrics["peak memory (MB)"] = first;
+    }
+    metrics["min density"] = minDensity;
+    metrics["max density"] = maxDensity;
+
+    std::ifstream fin(scratchFilepath);
+    size_t numFiller = 0;
+    while (std::getline(fin, line))
+        numFiller += !line.empty();
+    metrics["#fillers"] = numFiller;
+    return true;
+}
+
+bool Regression::measure(const std::string &inputFilepath, Metrics &metrics) const
+{
+    std::map<std::string, std::vector<double>> nameToValues;
+    for (size_t repeat = 0; repeat < numRepeat; ++repeat)
+    {
+        Metrics runMetrics;
+        if (!runOnce(inputFilepath, runMetrics))
+            return false;
+        for (const auto &[name, value] : runMetrics)
+            nameToValues[name].emplace_back(value);
+    }
+
+    // medians, the lower one for an even number of runs
+    metrics.clear();
+    for (auto &[name, values] : nameToValues)
+    {
+        std::nth_element(values.begin(), values.begin() + (values.size() - 1) / 2, values.end());
+        metrics[name] = values[(values.size() - 1) / 2];
+    }
+    return true;
+}
+
+bool Regression::readBaseline(const std::string &filepath, std::map<std::string, Metrics> &inputToMetrics)
+{
+    std::ifstream fin(filepath);
+    if (!fin)
+    {
+        std::cerr << "[Error] Cannot open \"" << filepath << "\".\n";
+        return false;
+    }
+
+    std::vector<std::string> path;
+    std::map<std::vector<std::string>, double> pathToNumber;
+    if (!JsonReader(fin).readObject(path, pathToNumber))
+    {
+        std::cerr << "[Error] \"" << filepath << "\" is not a baseline file.\n";
+        return false;
+    }
+    for (const auto &[numberPath, value] : pathToNumber)
+        if (numberPath.size() == 3 && numberPath[0] == "inputs")
+            inputToMetrics[numberPath[1]][numberPath[2]] = value;
+    return true;
+}
+
+bool Regression::writeBaseline(const std::string &filepath, const std::map<std::string, Metrics> &inputToMetrics)
+{
+    std::ofstream fout(filepath);
+    if (!fout)
+    {
+        std::cerr << "[Error] Cannot open \"" << filepath << "\".\n";
+        return false;
+    }
+
+    fout << "{\n  \"inputs\": {";
+    bool isFirstInput = true;
+    for (const auto &[inputFilepath, metrics] : inputToMetrics)
+    {
+        fout << (isFirstInput ? "" : ",") << "\n    " << toJsonString(inputFilepath) << ": {";
+        bool isFirstMetric = true;
+        for (const auto &[name, value] : metrics)
+        {
+            fout << (isFirstMetric ? "" : ",") << "\n      " << toJsonString(name) << ": " << value;
+            isFirstMetric = false;
+        }
+        fout << "\n    }";
+        isFirstInput = false;
+    }
+    fout << "\n  }\n}\n";
+    return static_cast<bool>(fout);
+}
+
+bool Regression::compare(std::ostream &output, const Metrics &baseline, const Metrics &current, const Threshold &threshold)
+{
+    bool isPassed = true;
+    char line[160];
+    std::snprintf(line, sizeof(line), "%-38s%14s%14s%10s  %s\n", "metric", "baseline", "current", "change", "status");
+    output << line;
+    for (const auto &[name, value] : current)
+    {
+        auto it = baseline.find(name);
+        if (it == baseline.end())
+        {
+            std::snprintf(line, sizeof(line), "%-38s%14s%14.4lf%10s  %s\n", name.c_str(), "-", value, "-", "new");
+            output << line;
+            continue;
+        }
+
+        // the change beyond the tolerance, in the worse direction: up for all metrics but the min density
+        double base = it->second;
+        double percent = (base != 0) ? 100 * (value - base) / base : 0;
+        double excess = 0;
+        if (name == "min density")
+            excess = std::abs(base - value) - threshold.density;
+        else if (name == "max density")
+            excess = std::abs(value - base) - threshold.density;
+        else if (name == "runtime (s)")
+            excess = std::abs(percent) - threshold.runtimePercent;
+        else if (name == "peak memory (MB)")
+            excess = std::abs(percent) - threshold.memoryPercent;
+        else if (name == "#fillers")
+            excess = std::abs(percent) - threshold.fillerPercent;
+        else if (base >= threshold.minPhaseSecond)
+            excess = std::abs(percent) - threshold.phasePercent;
+        bool isWorse = (name == "min density") ? value < base : value > base;
+        const char *status = (excess <= 0) ? "ok" : isWorse ? "REGRESSED"
+                                                            : "improved";
+        isPassed = isPassed && !(excess > 0 && isWorse);
+
+        std::snprintf(line, sizeof(line), "%-38s%14.4lf%14.4lf%+9.1lf%%  %s\n", name.c_str(), base, value, percent, status);
+        output << line;
+    }
+    return isPassed;
+}
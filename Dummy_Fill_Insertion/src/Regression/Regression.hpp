@@ -0,0 +1,36 @@
+#pragma once
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Performance regression gate: runs the solver on an input several times,
+// takes the medians of the runtime, the per-phase times and the peak memory
+// from its summary, the filler count and the final min/max window density,
+// and compares them against a baseline JSON file written by an earlier run.
+class Regression
+{
+public:
+    using Metrics = std::map<std::string, double>; // by metric name, e.g. "runtime (s)"
+
+    // relative tolerances in percent, the phases shorter than minPhaseSecond in the baseline are not gated
+    struct Threshold
+    {
+        double runtimePercent = 10, phasePercent = 20, minPhaseSecond = 0.05, memoryPercent = 10, fillerPercent = 1;
+        double density = 0.001; // absolute, on the min (lower is worse) and the max (higher is worse) density
+    };
+
+private:
+    std::string solverFilepath, scratchFilepath;
+    size_t numRepeat;
+
+    bool runOnce(const std::string &inputFilepath, Metrics &metrics) const;
+
+public:
+    Regression(const std::string &solverFilepath_, const std::string &scratchFilepath_, size_t numRepeat_);
+    bool measure(const std::string &inputFilepath, Metrics &metrics) const;
+    static bool readBaseline(const std::string &filepath, std::map<std::string, Metrics> &inputToMetrics);
+    static bool writeBaseline(const std::string &filepath, const std::map<std::string, Metrics> &inputToMetrics);
+    // print the table of one input, false if a metric is worse than its threshold
+    static bool compare(std::ostream &output, const Metrics &baseline, const Metrics &current, const Threshold &threshold);
+};
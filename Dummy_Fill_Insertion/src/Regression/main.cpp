@@ -0,0 +1,97 @@
+#include "Regression.hpp"
+#include <cstdlib>
+#include <iostream>
+#include <unistd.h>
+
+int main(int argc, char *argv[])
+{
+    std::string solverFilepath = "../bin/Fill_Insertion", scratchFilepath = "../output/regression.txt";
+    size_t numRepeat = 3;
+    bool isUpdate = false;
+    Regression::Threshold threshold;
+    int opt;
+    while ((opt = getopt(argc, argv, "hux:o:r:t:p:s:m:f:d:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'u':
+            isUpdate = true;
+            break;
+        case 'x':
+            solverFilepath = optarg;
+            break;
+        case 'o':
+            scratchFilepath = optarg;
+            break;
+        case 'r':
+            numRepeat = std::atoi(optarg);
+            break;
+        case 't':
+            threshold.runtimePercent = std::atof(optarg);
+            break;
+        case 'p':
+            threshold.phasePercent = std::atof(optarg);
+            break;
+        case 's':
+            threshold.minPhaseSecond = std::atof(optarg);
+            break;
+        case 'm':
+            threshold.memoryPercent = std::atof(optarg);
+            break;
+        case 'f':
+            threshold.fillerPercent = std::atof(optarg);
+            break;
+        case 'd':
+            threshold.density = std::atof(optarg);
+            break;
+        default:
+            optind = argc + 1;
+            break;
+        }
+    }
+    if (argc - optind < 2 || numRepeat == 0)
+    {
+        std::cerr << "Usage: " << argv[0] << " [-u] [-x <solver>] [-o <scratch output file>] [-r <#repeats>] [-t <runtime %>] [-p <phase %>] "
+                  << "[-s <min phase seconds>] [-m <memory %>] [-f <#fillers %>] [-d <density>] <baseline file> <input file>...\n";
+        return 1;
+    }
+
+    std::string baselineFilepath = argv[optind];
+    // an update keeps the baseline of the inputs not measured this time
+    std::map<std::string, Regression::Metrics> inputToBaseline;
+    if ((!isUpdate || access(baselineFilepath.c_str(), F_OK) == 0) && !Regression::readBaseline(baselineFilepath, inputToBaseline))
+        return 1;
+
+    Regression regression(solverFilepath, scratchFilepath, numRepeat);
+    bool isPassed = true;
+    for (int i = optind + 1; i < argc; ++i)
+    {
+        std::string inputFilepath = argv[i];
+        Regression::Metrics metrics;
+        if (!regression.measure(inputFilepath, metrics))
+            return 1;
+        if (isUpdate)
+        {
+            inputToBaseline[inputFilepath] = metrics;
+            continue;
+        }
+
+        std::cout << "----- " << inputFilepath << " (median of " << numRepeat << ") -----\n";
+        auto it = inputToBaseline.find(inputFilepath);
+        if (it == inputToBaseline.end())
+            std::cout << "[Warning] No baseline for \"" << inputFilepath << "\", run with -u to record one.\n";
+        else if (!Regression::compare(std::cout, it->second, metrics, threshold))
+            isPassed = false;
+        std::cout << "\n";
+    }
+
+    if (isUpdate)
+    {
+        if (!Regression::writeBaseline(baselineFilepath, inputToBaseline))
+            return 1;
+        std::cout << "Baseline written to \"" << baselineFilepath << "\".\n";
+        return 0;
+    }
+    std::cout << (isPassed ? "PASSED" : "FAILED") << "\n";
+    return isPassed ? 0 : 1;
+}
@@ -1,17 +1,47 @@
 #include "ResultWriter.hpp"
+#include "../MemoryTracker/MemoryReport.hpp"
 #include <fstream>
 #include <iostream>
 
-ResultWriter::ResultWriter() {}
+ResultWriter::ResultWriter(int64_t originX_, int64_t originY_)
+    : originX(originX_), originY(originY_) {}
 
-void ResultWriter::addFiller(const geometry::Rectangle &filler, int64_t layerId)
+ResultWriter::~ResultWriter()
+{
+    MemoryReport::release("ResultWriter");
+}
+
+void ResultWriter::addFiller(const geometry::CompactRectangle &filler, int64_t layerId)
 {
     layerToFillers[layerId].emplace_back(filler);
 }
 
-bool ResultWriter::write(const std::string &filepath) const
+const std::map<int64_t, std::vector<geometry::CompactRectangle>> &ResultWriter::getLayerToFillers() const
 {
-    std::ofstream fout(filepath);
+    return layerToFillers;
+}
+
+std::map<int64_t, std::vector<geometry::Rectangle>> ResultWriter::takeFillers(int64_t minY)
+{
+    std::map<int64_t, std::vector<geometry::Rectangle>> takenLayerToFillers;
+    for (auto &[layerId, fillers] : layerToFillers)
+    {
+        std::vector<geometry::CompactRectangle> keptFillers;
+        for (const geometry::CompactRectangle &filler : fillers)
+        {
+            if (filler.y2 + originY > minY)
+                takenLayerToFillers[layerId].emplace_back(geometry::Rectangle(filler).shift(originX, originY));
+            else
+                keptFillers.emplace_back(filler);
+        }
+        fillers.swap(keptFillers);
+    }
+    return takenLayerToFillers;
+}
+
+bool ResultWriter::write(const std::string &filepath, bool isAppend) const
+{
+    std::ofstream fout(filepath, isAppend ? std::ios::app : std::ios::trunc);
     if (!fout.is_open())
     {
         std::cerr << "[Error] Cannot open \"" << filepath << "\".\n";
@@ -19,7 +49,19 @@ bool ResultWriter::write(const std::string &filepath) const
     }
 
     for (const auto &[layerId, fillers] : layerToFillers)
-        for (const geometry::Rectangle &filler : fillers)
-            fout << filler.dumpCoordinates() << " " << layerId << "\n";
+        for (const geometry::CompactRectangle &filler : fillers)
+            fout << geometry::Rectangle(filler).shift(originX, originY).dumpCoordinates() << " " << layerId << "\n";
     return true;
 }
+
+void ResultWriter::recordMemory() const
+{
+    // a map node holds the key, the vector and about four words of tree links
+    size_t numFiller = 0, numByte = layerToFillers.size() * (sizeof(int64_t) + sizeof(std::vector<geometry::CompactRectangle>) + 4 * sizeof(void *));
+    for (const auto &[layerId, fillers] : layerToFillers)
+    {
+        numFiller += fillers.size();
+        numByte += MemoryReport::getNumByte(fillers);
+    }
+    MemoryReport::record("ResultWriter", "layerToFillers", numFiller, numByte);
+}
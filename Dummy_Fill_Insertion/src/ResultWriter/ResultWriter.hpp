@@ -7,12 +7,18 @@
 
 class ResultWriter
 {
-    std::map<int64_t, std::vector<geometry::Rectangle>> layerToFillers;
+    int64_t originX, originY; // fillers are kept chip-relative and shifted back on writing
+    std::map<int64_t, std::vector<geometry::CompactRectangle>> layerToFillers;
 
 public:
     using ptr = std::unique_ptr<ResultWriter>;
 
-    ResultWriter();
-    void addFiller(const geometry::Rectangle &filler, int64_t layerId);
-    bool write(const std::string &filepath) const;
+    ResultWriter(int64_t originX_ = 0, int64_t originY_ = 0);
+    ~ResultWriter();
+    void addFiller(const geometry::CompactRectangle &filler, int64_t layerId);
+    const std::map<int64_t, std::vector<geometry::CompactRectangle>> &getLayerToFillers() const; // chip-relative
+    // remove the fillers reaching above minY and return them in the input coordinates
+    std::map<int64_t, std::vector<geometry::Rectangle>> takeFillers(int64_t minY);
+    bool write(const std::string &filepath, bool isAppend = false) const;
+    void recordMemory() const; // in the memory report
 };
@@ -0,0 +1,63 @@
+#include "StripeSolver.hpp"
+#include "../DensityManager/DensityManager.hpp"
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <memory>
+
+StripeSolver::StripeSolver(const Parser *parser_, const StripeStore *stripeStore_, size_t numTileForWindow_, Timer *timer_)
+    : parser(parser_), stripeStore(stripeStore_), numTileForWindow(numTileForWindow_), timer(timer_) {}
+
+bool StripeSolver::solve(const std::string &outputFilepath)
+{
+    size_t numStripe = stripeStore->getNumStripe();
+    std::map<int64_t, std::vector<geometry::Rectangle>> carriedLayerToFillers;
+    for (size_t stripeIdx = 0; stripeIdx < numStripe; ++stripeIdx)
+    {
+        geometry::Rectangle ownedRegion = stripeStore->getOwnedRegion(stripeIdx);
+        geometry::Rectangle windowRegion = stripeStore->getWindowRegion(stripeIdx);
+        geometry::Rectangle loadRegion = stripeStore->getLoadRegion(stripeIdx);
+        std::cout << "===== STRIPE " << stripeIdx + 1 << "/" << numStripe << " =====\n"
+                  << "Owned y range:  " << ownedRegion.y1 << " " << ownedRegion.y2 << "\n"
+                  << "Window y range: " << windowRegion.y1 << " " << windowRegion.y2 << "\n"
+                  << "Load y range:   " << loadRegion.y1 << " " << loadRegion.y2 << "\n"
+                  << "\n";
+
+        process::Database::ptr db = parser->createDatabase(loadRegion, stripeStore->load(stripeIdx));
+        db->isIncremental = true;
+        db->isPartial = true;
+        // the windows crossing the row above the owned rows are checked by the next stripe
+        db->windowBoundary = db->toRelative(windowRegion);
+
+        // refill exactly the refill rows, markDirtyTile() expands the changed region by the spacing
+        geometry::Rectangle refillRegion = stripeStore->getRefillRegion(stripeIdx);
+        for (process::Layer::ptr &layer : db->layers)
+        {
+            geometry::CompactRectangle changedRegion = db->toRelative(refillRegion);
+            changedRegion.expand(0, -layer->minSpacing, 0, -layer->minSpacing);
+            layer->changedRegions.emplace_back(changedRegion);
+            for (const geometry::Rectangle &filler : carriedLayerToFillers[layer->id])
+                layer->previousFillers.emplace_back(db->toRelative(filler));
+        }
+        carriedLayerToFillers.clear();
+
+        // share the remaining time equally among the remaining stripes
+        std::unique_ptr<Timer> stripeTimer;
+        if (timer)
+        {
+            auto remainingTime = std::chrono::duration_cast<std::chrono::seconds>(timer->getRemainingTime());
+            int numSecond = static_cast<int>(remainingTime.count() / static_cast<int64_t>(numStripe - stripeIdx));
+            stripeTimer.reset(new Timer(std::max(numSecond, 1)));
+        }
+
+        DensityManager densityManager(db.get(), numTileForWindow, stripeTimer.get());
+        ResultWriter::ptr result = densityManager.solve();
+
+        // the fillers reaching the windows of the next stripe are written out by the next stripe
+        if (stripeIdx + 1 < numStripe)
+            carriedLayerToFillers = result->takeFillers(stripeStore->getWindowRegion(stripeIdx + 1).y1);
+        if (!result->write(outputFilepath, stripeIdx > 0))
+            return false;
+    }
+    return true;
+}
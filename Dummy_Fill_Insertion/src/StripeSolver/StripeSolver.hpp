@@ -0,0 +1,22 @@
+#pragma once
+#include "../Parser/Parser.hpp"
+#include "../Timer/Timer.hpp"
+#include "StripeStore.hpp"
+#include <string>
+
+// Out-of-core solving: the stripes of the stripe store are solved bottom-up,
+// one at a time, as incremental (ECO) problems. The rows of a stripe are
+// filled again, the fillers carried over from the previous stripe stay in
+// place below them, and only the fillers that no later stripe can touch are
+// written out before the stripe is dropped.
+class StripeSolver
+{
+    const Parser *parser;
+    const StripeStore *stripeStore;
+    size_t numTileForWindow;
+    Timer *timer;
+
+public:
+    StripeSolver(const Parser *parser_, const StripeStore *stripeStore_, size_t numTileForWindow_, Timer *timer_ = nullptr);
+    bool solve(const std::string &outputFilepath);
+};
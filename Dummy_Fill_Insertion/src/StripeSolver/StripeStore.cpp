@@ -0,0 +1,193 @@
+#include "StripeStore.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <unistd.h>
+
+std::string StripeStore::getBucketFilepath(size_t stripeIdx) const
+{
+    return directory + "/stripe" + std::to_string(stripeIdx) + ".bin";
+}
+
+void StripeStore::flush(size_t stripeIdx)
+{
+    std::vector<Record> &buffer = buffers[stripeIdx];
+    if (buffer.empty())
+        return;
+
+    // reopen in append mode rather than keeping one stream per stripe open
+    std::ofstream fout(getBucketFilepath(stripeIdx), std::ios::binary | std::ios::app);
+    fout.write(reinterpret_cast<const char *>(buffer.data()), buffer.size() * sizeof(Record));
+    if (!fout)
+    {
+        std::cerr << "[Error] Cannot write \"" << getBucketFilepath(stripeIdx) << "\".\n";
+        isFailed = true;
+    }
+    buffer.clear();
+}
+
+size_t StripeStore::getRefillBeginTileRow(size_t stripeIdx) const
+{
+    size_t ownedBeginRowIdx = stripeIdx * numTileRowPerStripe;
+    return (ownedBeginRowIdx > numTileForWindow - 1) ? ownedBeginRowIdx - (numTileForWindow - 1) : 0;
+}
+
+size_t StripeStore::getWindowBeginTileRow(size_t stripeIdx) const
+{
+    size_t refillBeginRowIdx = getRefillBeginTileRow(stripeIdx);
+    size_t haloRow = 2 * (numTileForWindow - 1);
+    return (refillBeginRowIdx > haloRow) ? refillBeginRowIdx - haloRow : 0;
+}
+
+std::pair<size_t, size_t> StripeStore::getLoadTileRow(size_t stripeIdx) const
+{
+    size_t windowBeginRowIdx = getWindowBeginTileRow(stripeIdx);
+    size_t ownedEndRowIdx = std::min((stripeIdx + 1) * numTileRowPerStripe, numTileRow);
+    size_t beginRowIdx = (windowBeginRowIdx > numContextRow) ? windowBeginRowIdx - numContextRow : 0;
+    size_t endRowIdx = std::min(ownedEndRowIdx + 1, numTileRow);
+    return {beginRowIdx, endRowIdx};
+}
+
+int64_t StripeStore::getTileRowY(size_t rowIdx) const
+{
+    // the last row absorbs the remainder of the chip height
+    return (rowIdx == numTileRow) ? chipBoundary.y2 : chipBoundary.y1 + static_cast<int64_t>(rowIdx) * tileSize;
+}
+
+StripeStore::StripeStore(size_t numTileForWindow_, size_t numWindowPerStripe)
+    : numTileForWindow(numTileForWindow_), numTileRowPerStripe(numTileForWindow_ * numWindowPerStripe),
+      windowSize(0), tileSize(0), numTileRow(0), numContextRow(0), numStripe(0), numStoredConductor(0), isFailed(false) {}
+
+StripeStore::~StripeStore()
+{
+    if (directory.empty())
+        return;
+    for (size_t stripeIdx = 0; stripeIdx < numStripe; ++stripeIdx)
+        unlink(getBucketFilepath(stripeIdx).c_str());
+    rmdir(directory.c_str());
+}
+
+bool StripeStore::open(const geometry::Rectangle &chipBoundary_, int64_t windowSize_, int64_t maxFillWidth)
+{
+    chipBoundary = chipBoundary_;
+    windowSize = windowSize_;
+    tileSize = windowSize / numTileForWindow;
+    numTileRow = chipBoundary.height() / tileSize;
+    numContextRow = (maxFillWidth + tileSize - 1) / tileSize;
+    numStripe = (numTileRow + numTileRowPerStripe - 1) / numTileRowPerStripe;
+    buffers.assign(numStripe, std::vector<Record>());
+
+    const char *tmpDirectory = std::getenv("TMPDIR");
+    std::string pattern = std::string((tmpDirectory && *tmpDirectory) ? tmpDirectory : "/tmp") + "/fill_stripe_XXXXXX";
+    std::vector<char> path(pattern.begin(), pattern.end());
+    path.emplace_back('\0');
+    if (!mkdtemp(path.data()))
+    {
+        std::cerr << "[Error] Cannot create the stripe directory \"" << pattern << "\".\n";
+        return false;
+    }
+    directory = path.data();
+    return true;
+}
+
+void StripeStore::addConductor(const raw::Conductor &conductor)
+{
+    int64_t beginY = std::max(conductor.y1, chipBoundary.y1) - chipBoundary.y1;
+    int64_t endY = std::min(conductor.y2, chipBoundary.y2) - chipBoundary.y1;
+    if (endY <= beginY || conductor.width() <= 0)
+        return;
+
+    // the loading regions of neighbouring stripes overlap, so a conductor can go to several buckets
+    size_t beginRowIdx = std::min<size_t>(beginY / tileSize, numTileRow - 1);
+    size_t endRowIdx = std::min<size_t>((endY + tileSize - 1) / tileSize, numTileRow);
+    size_t beginStripeIdx = 0;
+    while (beginStripeIdx + 1 < numStripe && getLoadTileRow(beginStripeIdx).second <= beginRowIdx)
+        ++beginStripeIdx;
+    for (size_t stripeIdx = beginStripeIdx; stripeIdx < numStripe; ++stripeIdx)
+    {
+        auto [loadBeginRowIdx, loadEndRowIdx] = getLoadTileRow(stripeIdx);
+        if (loadBeginRowIdx >= endRowIdx)
+            break;
+        if (loadEndRowIdx <= beginRowIdx)
+            continue;
+
+        buffers[stripeIdx].push_back({conductor.x1, conductor.y1, conductor.x2, conductor.y2, conductor.netId, conductor.layerId});
+        ++numStoredConductor;
+        if (buffers[stripeIdx].size() >= maxNumBufferRecord)
+            flush(stripeIdx);
+    }
+}
+
+bool StripeStore::close()
+{
+    for (size_t stripeIdx = 0; stripeIdx < numStripe; ++stripeIdx)
+        flush(stripeIdx);
+    buffers.clear();
+    buffers.shrink_to_fit();
+    return !isFailed;
+}
+
+int64_t StripeStore::getWindowSize() const
+{
+    return windowSize;
+}
+
+size_t StripeStore::getNumStripe() const
+{
+    return numStripe;
+}
+
+size_t StripeStore::getNumStoredConductor() const
+{
+    return numStoredConductor;
+}
+
+geometry::Rectangle StripeStore::getOwnedRegion(size_t stripeIdx) const
+{
+    size_t beginRowIdx = stripeIdx * numTileRowPerStripe;
+    size_t endRowIdx = std::min(beginRowIdx + numTileRowPerStripe, numTileRow);
+    return geometry::Rectangle(chipBoundary.x1, getTileRowY(beginRowIdx), chipBoundary.x2, getTileRowY(endRowIdx));
+}
+
+geometry::Rectangle StripeStore::getRefillRegion(size_t stripeIdx) const
+{
+    size_t beginRowIdx = getRefillBeginTileRow(stripeIdx);
+    size_t endRowIdx = std::min((stripeIdx + 1) * numTileRowPerStripe, numTileRow);
+    return geometry::Rectangle(chipBoundary.x1, getTileRowY(beginRowIdx), chipBoundary.x2, getTileRowY(endRowIdx));
+}
+
+geometry::Rectangle StripeStore::getWindowRegion(size_t stripeIdx) const
+{
+    size_t beginRowIdx = getWindowBeginTileRow(stripeIdx);
+    size_t endRowIdx = std::min((stripeIdx + 1) * numTileRowPerStripe, numTileRow);
+    return geometry::Rectangle(chipBoundary.x1, getTileRowY(beginRowIdx), chipBoundary.x2, getTileRowY(endRowIdx));
+}
+
+geometry::Rectangle StripeStore::getLoadRegion(size_t stripeIdx) const
+{
+    auto [beginRowIdx, endRowIdx] = getLoadTileRow(stripeIdx);
+    return geometry::Rectangle(chipBoundary.x1, getTileRowY(beginRowIdx), chipBoundary.x2, getTileRowY(endRowIdx));
+}
+
+std::vector<raw::Conductor::ptr> StripeStore::load(size_t stripeIdx) const
+{
+    std::vector<raw::Conductor::ptr> conductors;
+    std::ifstream fin(getBucketFilepath(stripeIdx), std::ios::binary);
+    if (!fin.is_open())
+        return conductors; // no conductor in the stripe
+
+    Record record;
+    while (fin.read(reinterpret_cast<char *>(&record), sizeof(Record)))
+    {
+        raw::Conductor *conductor = new raw::Conductor();
+        conductor->x1 = record.x1;
+        conductor->y1 = record.y1;
+        conductor->x2 = record.x2;
+        conductor->y2 = record.y2;
+        conductor->netId = record.netId;
+        conductor->layerId = record.layerId;
+        conductors.emplace_back(conductor);
+    }
+    return conductors;
+}
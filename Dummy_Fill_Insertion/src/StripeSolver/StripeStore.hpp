@@ -0,0 +1,64 @@
+#pragma once
+#include "../Structure/Geometry/Geometry.hpp"
+#include "../Structure/Raw/Raw.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+// On-disk layout of the conductors for the out-of-core (stripe) mode.
+// The chip is cut into horizontal stripes of window rows. Each conductor is
+// appended to the bucket file of every stripe whose loading region it
+// intersects, so a stripe is read back with one sequential scan of its bucket.
+//
+// A stripe owns the tile rows [ownedBegin, ownedEnd) and fills again from
+// n - 1 rows below them, so that every window the previous stripe did not
+// check lies in freshly filled rows. The next n - 1 rows are dirty and the
+// n - 1 rows below those keep their fillers fixed; windows are checked from
+// there up to ownedEnd. The loading region adds the rows needed to hold a
+// filler crossing the lowest window row, and one row above for the
+// conductors within spacing distance of the owned rows.
+class StripeStore
+{
+    struct Record
+    {
+        int64_t x1, y1, x2, y2, netId, layerId;
+    };
+
+    static constexpr size_t maxNumBufferRecord = 4096; // per stripe, flushed to the bucket file when full
+
+    size_t numTileForWindow, numTileRowPerStripe;
+    geometry::Rectangle chipBoundary;
+    int64_t windowSize, tileSize;
+    size_t numTileRow, numContextRow, numStripe, numStoredConductor;
+    std::string directory;
+    std::vector<std::vector<Record>> buffers;
+    bool isFailed;
+
+    std::string getBucketFilepath(size_t stripeIdx) const;
+    void flush(size_t stripeIdx);
+    size_t getRefillBeginTileRow(size_t stripeIdx) const;
+    size_t getWindowBeginTileRow(size_t stripeIdx) const;
+    std::pair<size_t, size_t> getLoadTileRow(size_t stripeIdx) const;
+    int64_t getTileRowY(size_t rowIdx) const;
+
+public:
+    using ptr = std::unique_ptr<StripeStore>;
+
+    StripeStore(size_t numTileForWindow_, size_t numWindowPerStripe);
+    ~StripeStore();
+    StripeStore(const StripeStore &) = delete;
+    StripeStore &operator=(const StripeStore &) = delete;
+
+    bool open(const geometry::Rectangle &chipBoundary_, int64_t windowSize_, int64_t maxFillWidth);
+    void addConductor(const raw::Conductor &conductor);
+    bool close();
+
+    int64_t getWindowSize() const;
+    size_t getNumStripe() const;
+    size_t getNumStoredConductor() const;
+    geometry::Rectangle getOwnedRegion(size_t stripeIdx) const;
+    geometry::Rectangle getRefillRegion(size_t stripeIdx) const;
+    geometry::Rectangle getWindowRegion(size_t stripeIdx) const;
+    geometry::Rectangle getLoadRegion(size_t stripeIdx) const;
+    std::vector<raw::Conductor::ptr> load(size_t stripeIdx) const;
+};
@@ -1,29 +1,36 @@
 #include "Geometry.hpp"
+#include <algorithm>
 #include <limits>
 #include <sstream>
 
-geometry::Rectangle::Rectangle()
+template <typename T>
+geometry::BasicRectangle<T>::BasicRectangle()
     : x1(0), y1(0), x2(0), y2(0) {}
 
-geometry::Rectangle::Rectangle(int64_t x1_, int64_t y1_, int64_t x2_, int64_t y2_)
+template <typename T>
+geometry::BasicRectangle<T>::BasicRectangle(T x1_, T y1_, T x2_, T y2_)
     : x1(x1_), y1(y1_), x2(x2_), y2(y2_) {}
 
-int64_t geometry::Rectangle::width() const
+template <typename T>
+T geometry::BasicRectangle<T>::width() const
 {
     return x2 - x1;
 }
 
-int64_t geometry::Rectangle::height() const
+template <typename T>
+T geometry::BasicRectangle<T>::height() const
 {
     return y2 - y1;
 }
 
-int64_t geometry::Rectangle::area() const
+template <typename T>
+int64_t geometry::BasicRectangle<T>::area() const
 {
-    return width() * height();
+    return static_cast<int64_t>(width()) * height();
 }
 
-double geometry::Rectangle::aspectRatio() const
+template <typename T>
+double geometry::BasicRectangle<T>::aspectRatio() const
 {
     if (height() == 0)
         return std::numeric_limits<double>::max();
@@ -31,19 +38,22 @@ double geometry::Rectangle::aspectRatio() const
         return static_cast<double>(width()) / height();
 }
 
-std::string geometry::Rectangle::dumpCoordinates() const
+template <typename T>
+std::string geometry::BasicRectangle<T>::dumpCoordinates() const
 {
     std::stringstream ss;
     ss << x1 << " " << y1 << " " << x2 << " " << y2;
     return ss.str();
 }
 
-bool geometry::Rectangle::isLegal() const
+template <typename T>
+bool geometry::BasicRectangle<T>::isLegal() const
 {
     return width() > 0 && height() > 0;
 }
 
-geometry::Rectangle &geometry::Rectangle::shift(int64_t offsetX, int64_t offsetY)
+template <typename T>
+geometry::BasicRectangle<T> &geometry::BasicRectangle<T>::shift(T offsetX, T offsetY)
 {
     x1 += offsetX;
     y1 += offsetY;
@@ -52,7 +62,8 @@ geometry::Rectangle &geometry::Rectangle::shift(int64_t offsetX, int64_t offsetY
     return *this;
 }
 
-geometry::Rectangle &geometry::Rectangle::scale(double scaling)
+template <typename T>
+geometry::BasicRectangle<T> &geometry::BasicRectangle<T>::scale(double scaling)
 {
     x1 *= scaling;
     y1 *= scaling;
@@ -61,7 +72,8 @@ geometry::Rectangle &geometry::Rectangle::scale(double scaling)
     return *this;
 }
 
-geometry::Rectangle &geometry::Rectangle::expand(int64_t lowerLeft, int64_t upperRight)
+template <typename T>
+geometry::BasicRectangle<T> &geometry::BasicRectangle<T>::expand(T lowerLeft, T upperRight)
 {
     x1 -= lowerLeft;
     y1 -= lowerLeft;
@@ -70,7 +82,8 @@ geometry::Rectangle &geometry::Rectangle::expand(int64_t lowerLeft, int64_t uppe
     return *this;
 }
 
-geometry::Rectangle &geometry::Rectangle::expand(int64_t left, int64_t lower, int64_t right, int64_t upper)
+template <typename T>
+geometry::BasicRectangle<T> &geometry::BasicRectangle<T>::expand(T left, T lower, T right, T upper)
 {
     x1 -= left;
     y1 -= lower;
@@ -79,46 +92,62 @@ geometry::Rectangle &geometry::Rectangle::expand(int64_t left, int64_t lower, in
     return *this;
 }
 
-geometry::Rectangle &geometry::Rectangle::transform()
+template <typename T>
+geometry::BasicRectangle<T> &geometry::BasicRectangle<T>::transform()
 {
     std::swap(x1, y1);
     std::swap(x2, y2);
     return *this;
 }
 
-bool geometry::isIntersect(const geometry::Rectangle &a, const geometry::Rectangle &b)
+template <typename T>
+bool geometry::isIntersect(const geometry::BasicRectangle<T> &a, const geometry::BasicRectangle<T> &b)
 {
     return !(a.x2 <= b.x1 || b.x2 <= a.x1 || a.y2 <= b.y1 || b.y2 <= a.y1);
 }
 
-geometry::Rectangle geometry::getIntersectRegion(const geometry::Rectangle &a, const geometry::Rectangle &b)
+template <typename T>
+geometry::BasicRectangle<T> geometry::getIntersectRegion(const geometry::BasicRectangle<T> &a, const geometry::BasicRectangle<T> &b)
 {
     if (!isIntersect(a, b))
-        return geometry::Rectangle();
+        return geometry::BasicRectangle<T>();
 
-    int64_t beginX = std::max(a.x1, b.x1);
-    int64_t beginY = std::max(a.y1, b.y1);
-    int64_t endX = std::min(a.x2, b.x2);
-    int64_t endY = std::min(a.y2, b.y2);
-    return geometry::Rectangle(beginX, beginY, endX, endY);
+    T beginX = std::max(a.x1, b.x1);
+    T beginY = std::max(a.y1, b.y1);
+    T endX = std::min(a.x2, b.x2);
+    T endY = std::min(a.y2, b.y2);
+    return geometry::BasicRectangle<T>(beginX, beginY, endX, endY);
 }
 
-int64_t geometry::getDistance(const geometry::Rectangle &a, const geometry::Rectangle &b)
+template <typename T>
+int64_t geometry::getDistance(const geometry::BasicRectangle<T> &a, const geometry::BasicRectangle<T> &b)
 {
-    int64_t lenX = std::max(a.x1, b.x1) - std::min(a.x2, b.x2);
-    int64_t lenY = std::max(a.y1, b.y1) - std::min(a.y2, b.y2);
+    int64_t lenX = static_cast<int64_t>(std::max(a.x1, b.x1)) - std::min(a.x2, b.x2);
+    int64_t lenY = static_cast<int64_t>(std::max(a.y1, b.y1)) - std::min(a.y2, b.y2);
     lenX = (lenX < 0) ? 0 : lenX;
     lenY = (lenY < 0) ? 0 : lenY;
     return lenX + lenY;
 }
 
-int64_t geometry::getParallelLength(const geometry::Rectangle &a, const geometry::Rectangle &b)
+template <typename T>
+int64_t geometry::getParallelLength(const geometry::BasicRectangle<T> &a, const geometry::BasicRectangle<T> &b)
 {
-    int64_t lenX = std::min(a.x2, b.x2) - std::max(a.x1, b.x1);
-    int64_t lenY = std::min(a.y2, b.y2) - std::max(a.y1, b.y1);
+    int64_t lenX = static_cast<int64_t>(std::min(a.x2, b.x2)) - std::max(a.x1, b.x1);
+    int64_t lenY = static_cast<int64_t>(std::min(a.y2, b.y2)) - std::max(a.y1, b.y1);
     if (lenX > 0 && lenY <= 0)
         return lenX;
     else if (lenX <= 0 && lenY > 0)
         return lenY;
     return 0;
 }
+
+#define INSTANTIATE_RECTANGLE(T)                                                                                 \
+    template struct geometry::BasicRectangle<T>;                                                                 \
+    template bool geometry::isIntersect(const geometry::BasicRectangle<T> &, const geometry::BasicRectangle<T> &); \
+    template geometry::BasicRectangle<T> geometry::getIntersectRegion(const geometry::BasicRectangle<T> &,       \
+                                                                      const geometry::BasicRectangle<T> &);      \
+    template int64_t geometry::getDistance(const geometry::BasicRectangle<T> &, const geometry::BasicRectangle<T> &); \
+    template int64_t geometry::getParallelLength(const geometry::BasicRectangle<T> &, const geometry::BasicRectangle<T> &);
+
+INSTANTIATE_RECTANGLE(int64_t)
+INSTANTIATE_RECTANGLE(int32_t)
@@ -1,33 +1,46 @@
 #pragma once
+#include <cstdint>
 #include <memory>
 #include <string>
 
 namespace geometry
 {
-    struct Rectangle
+    template <typename T>
+    struct BasicRectangle
     {
-        using ptr = std::unique_ptr<Rectangle>;
+        using ptr = std::unique_ptr<BasicRectangle>;
+        using Coordinate = T;
 
-        int64_t x1, y1, x2, y2; // lower-left coordinate (x1, y1), upper-right coordinate (x2, y2)
+        T x1, y1, x2, y2; // lower-left coordinate (x1, y1), upper-right coordinate (x2, y2)
 
-        Rectangle();
-        Rectangle(int64_t x1_, int64_t y1_, int64_t x2_, int64_t y2_);
-        int64_t width() const;
-        int64_t height() const;
-        int64_t area() const;
+        BasicRectangle();
+        BasicRectangle(T x1_, T y1_, T x2_, T y2_);
+        template <typename U>
+        explicit BasicRectangle(const BasicRectangle<U> &rectangle)
+            : x1(rectangle.x1), y1(rectangle.y1), x2(rectangle.x2), y2(rectangle.y2) {}
+        T width() const;
+        T height() const;
+        int64_t area() const; // always 64-bit, also for 32-bit coordinates
         double aspectRatio() const;
         std::string dumpCoordinates() const;
         bool isLegal() const;
-        Rectangle &shift(int64_t offsetX, int64_t offsetY);
-        Rectangle &scale(double scaling = 1);
-        Rectangle &expand(int64_t lowerLeft, int64_t upperRight);
-        Rectangle &expand(int64_t left, int64_t lower, int64_t right, int64_t upper);
-        Rectangle &transform();
+        BasicRectangle &shift(T offsetX, T offsetY);
+        BasicRectangle &scale(double scaling = 1);
+        BasicRectangle &expand(T lowerLeft, T upperRight);
+        BasicRectangle &expand(T left, T lower, T right, T upper);
+        BasicRectangle &transform();
     };
 
+    using Rectangle = BasicRectangle<int64_t>;        // absolute coordinates of the input and output files
+    using CompactRectangle = BasicRectangle<int32_t>; // chip-relative coordinates used inside the solver
+
     // utility function
-    bool isIntersect(const Rectangle &a, const Rectangle &b);
-    Rectangle getIntersectRegion(const Rectangle &a, const Rectangle &b);
-    int64_t getDistance(const Rectangle &a, const Rectangle &b);
-    int64_t getParallelLength(const Rectangle &a, const Rectangle &b);
+    template <typename T>
+    bool isIntersect(const BasicRectangle<T> &a, const BasicRectangle<T> &b);
+    template <typename T>
+    BasicRectangle<T> getIntersectRegion(const BasicRectangle<T> &a, const BasicRectangle<T> &b);
+    template <typename T>
+    int64_t getDistance(const BasicRectangle<T> &a, const BasicRectangle<T> &b);
+    template <typename T>
+    int64_t getParallelLength(const BasicRectangle<T> &a, const BasicRectangle<T> &b);
 }
@@ -0,0 +1,340 @@
+#include "RectangleBatch.hpp"
+#include <algorithm>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define RECTANGLE_BATCH_X86
+#endif
+
+namespace
+{
+    using IntersectKernel = void (*)(const geometry::CompactRectangle &, const int32_t *, const int32_t *,
+                                     const int32_t *, const int32_t *, size_t, std::vector<uint32_t> &);
+    using MeasureKernel = void (*)(const geometry::CompactRectangle &, const int32_t *, const int32_t *,
+                                   const int32_t *, const int32_t *, size_t, int64_t *);
+
+    // scalar kernels, also used for the tails of the vector kernels
+
+    void selectIntersectScalar(const geometry::CompactRectangle &q, const int32_t *x1s, const int32_t *y1s,
+                               const int32_t *x2s, const int32_t *y2s, size_t n, std::vector<uint32_t> &indices)
+    {
+        for (size_t i = 0; i < n; ++i)
+            if (x1s[i] < q.x2 && q.x1 < x2s[i] && y1s[i] < q.y2 && q.y1 < y2s[i])
+                indices.emplace_back(i);
+    }
+
+    void getDistanceScalar(const geometry::CompactRectangle &q, const int32_t *x1s, const int32_t *y1s,
+                           const int32_t *x2s, const int32_t *y2s, size_t n, int64_t *distances)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            int64_t lenX = static_cast<int64_t>(std::max(q.x1, x1s[i])) - std::min(q.x2, x2s[i]);
+            int64_t lenY = static_cast<int64_t>(std::max(q.y1, y1s[i])) - std::min(q.y2, y2s[i]);
+            distances[i] = std::max<int64_t>(lenX, 0) + std::max<int64_t>(lenY, 0);
+        }
+    }
+
+    void getParallelLengthScalar(const geometry::CompactRectangle &q, const int32_t *x1s, const int32_t *y1s,
+                                 const int32_t *x2s, const int32_t *y2s, size_t n, int64_t *lengths)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            int64_t lenX = static_cast<int64_t>(std::min(q.x2, x2s[i])) - std::max(q.x1, x1s[i]);
+            int64_t lenY = static_cast<int64_t>(std::min(q.y2, y2s[i])) - std::max(q.y1, y1s[i]);
+            if (lenX > 0 && lenY <= 0)
+                lengths[i] = lenX;
+            else if (lenX <= 0 && lenY > 0)
+                lengths[i] = lenY;
+            else
+                lengths[i] = 0;
+        }
+    }
+
+#ifdef RECTANGLE_BATCH_X86
+    // AVX2 kernels, 8 rectangles per iteration. The differences of chip-relative
+    // coordinates fit in 32 bits, the results are widened to 64 bits on store.
+
+    __attribute__((target("avx2"))) inline void store256(int64_t *output, __m256i lower, __m256i upper)
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(output), lower);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(output + 4), upper);
+    }
+
+    __attribute__((target("avx2"))) inline __m256i widenLower256(__m256i v)
+    {
+        return _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v));
+    }
+
+    __attribute__((target("avx2"))) inline __m256i widenUpper256(__m256i v)
+    {
+        return _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1));
+    }
+
+    __attribute__((target("avx2"))) void selectIntersectAvx2(const geometry::CompactRectangle &q, const int32_t *x1s, const int32_t *y1s,
+                                                             const int32_t *x2s, const int32_t *y2s, size_t n, std::vector<uint32_t> &indices)
+    {
+        const __m256i qx1 = _mm256_set1_epi32(q.x1), qy1 = _mm256_set1_epi32(q.y1);
+        const __m256i qx2 = _mm256_set1_epi32(q.x2), qy2 = _mm256_set1_epi32(q.y2);
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8)
+        {
+            __m256i bx1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(x1s + i));
+            __m256i by1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(y1s + i));
+            __m256i bx2 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(x2s + i));
+            __m256i by2 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(y2s + i));
+            __m256i m = _mm256_and_si256(_mm256_and_si256(_mm256_cmpgt_epi32(qx2, bx1), _mm256_cmpgt_epi32(bx2, qx1)),
+                                         _mm256_and_si256(_mm256_cmpgt_epi32(qy2, by1), _mm256_cmpgt_epi32(by2, qy1)));
+            int mask = _mm256_movemask_ps(_mm256_castsi256_ps(m));
+            while (mask)
+            {
+                indices.emplace_back(i + __builtin_ctz(mask));
+                mask &= mask - 1;
+            }
+        }
+        for (; i < n; ++i)
+            if (x1s[i] < q.x2 && q.x1 < x2s[i] && y1s[i] < q.y2 && q.y1 < y2s[i])
+                indices.emplace_back(i);
+    }
+
+    __attribute__((target("avx2"))) void getDistanceAvx2(const geometry::CompactRectangle &q, const int32_t *x1s, const int32_t *y1s,
+                                                         const int32_t *x2s, const int32_t *y2s, size_t n, int64_t *distances)
+    {
+        const __m256i qx1 = _mm256_set1_epi32(q.x1), qy1 = _mm256_set1_epi32(q.y1);
+        const __m256i qx2 = _mm256_set1_epi32(q.x2), qy2 = _mm256_set1_epi32(q.y2);
+        const __m256i zero = _mm256_setzero_si256();
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8)
+        {
+            __m256i bx1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(x1s + i));
+            __m256i by1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(y1s + i));
+            __m256i bx2 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(x2s + i));
+            __m256i by2 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(y2s + i));
+            __m256i lenX = _mm256_max_epi32(_mm256_sub_epi32(_mm256_max_epi32(qx1, bx1), _mm256_min_epi32(qx2, bx2)), zero);
+            __m256i lenY = _mm256_max_epi32(_mm256_sub_epi32(_mm256_max_epi32(qy1, by1), _mm256_min_epi32(qy2, by2)), zero);
+            store256(distances + i, _mm256_add_epi64(widenLower256(lenX), widenLower256(lenY)),
+                     _mm256_add_epi64(widenUpper256(lenX), widenUpper256(lenY)));
+        }
+        getDistanceScalar(q, x1s + i, y1s + i, x2s + i, y2s + i, n - i, distances + i);
+    }
+
+    __attribute__((target("avx2"))) void getParallelLengthAvx2(const geometry::CompactRectangle &q, const int32_t *x1s, const int32_t *y1s,
+                                                               const int32_t *x2s, const int32_t *y2s, size_t n, int64_t *lengths)
+    {
+        const __m256i qx1 = _mm256_set1_epi32(q.x1), qy1 = _mm256_set1_epi32(q.y1);
+        const __m256i qx2 = _mm256_set1_epi32(q.x2), qy2 = _mm256_set1_epi32(q.y2);
+        const __m256i zero = _mm256_setzero_si256();
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8)
+        {
+            __m256i bx1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(x1s + i));
+            __m256i by1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(y1s + i));
+            __m256i bx2 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(x2s + i));
+            __m256i by2 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(y2s + i));
+            __m256i lenX = _mm256_sub_epi32(_mm256_min_epi32(qx2, bx2), _mm256_max_epi32(qx1, bx1));
+            __m256i lenY = _mm256_sub_epi32(_mm256_min_epi32(qy2, by2), _mm256_max_epi32(qy1, by1));
+            __m256i isX = _mm256_cmpgt_epi32(lenX, zero);
+            __m256i isY = _mm256_cmpgt_epi32(lenY, zero);
+            __m256i len = _mm256_or_si256(_mm256_and_si256(_mm256_andnot_si256(isY, isX), lenX),
+                                          _mm256_and_si256(_mm256_andnot_si256(isX, isY), lenY));
+            store256(lengths + i, widenLower256(len), widenUpper256(len));
+        }
+        getParallelLengthScalar(q, x1s + i, y1s + i, x2s + i, y2s + i, n - i, lengths + i);
+    }
+
+    // SSE4.1 kernels, 4 rectangles per iteration
+
+    __attribute__((target("sse4.1"))) inline void store128(int64_t *output, __m128i lower, __m128i upper)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(output), lower);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(output + 2), upper);
+    }
+
+    __attribute__((target("sse4.1"))) inline __m128i widenLower128(__m128i v)
+    {
+        return _mm_cvtepi32_epi64(v);
+    }
+
+    __attribute__((target("sse4.1"))) inline __m128i widenUpper128(__m128i v)
+    {
+        return _mm_cvtepi32_epi64(_mm_srli_si128(v, 8));
+    }
+
+    __attribute__((target("sse4.1"))) void selectIntersectSse(const geometry::CompactRectangle &q, const int32_t *x1s, const int32_t *y1s,
+                                                              const int32_t *x2s, const int32_t *y2s, size_t n, std::vector<uint32_t> &indices)
+    {
+        const __m128i qx1 = _mm_set1_epi32(q.x1), qy1 = _mm_set1_epi32(q.y1);
+        const __m128i qx2 = _mm_set1_epi32(q.x2), qy2 = _mm_set1_epi32(q.y2);
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            __m128i bx1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(x1s + i));
+            __m128i by1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(y1s + i));
+            __m128i bx2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(x2s + i));
+            __m128i by2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(y2s + i));
+            __m128i m = _mm_and_si128(_mm_and_si128(_mm_cmpgt_epi32(qx2, bx1), _mm_cmpgt_epi32(bx2, qx1)),
+                                      _mm_and_si128(_mm_cmpgt_epi32(qy2, by1), _mm_cmpgt_epi32(by2, qy1)));
+            int mask = _mm_movemask_ps(_mm_castsi128_ps(m));
+            while (mask)
+            {
+                indices.emplace_back(i + __builtin_ctz(mask));
+                mask &= mask - 1;
+            }
+        }
+        for (; i < n; ++i)
+            if (x1s[i] < q.x2 && q.x1 < x2s[i] && y1s[i] < q.y2 && q.y1 < y2s[i])
+                indices.emplace_back(i);
+    }
+
+    __attribute__((target("sse4.1"))) void getDistanceSse(const geometry::CompactRectangle &q, const int32_t *x1s, const int32_t *y1s,
+                                                          const int32_t *x2s, const int32_t *y2s, size_t n, int64_t *distances)
+    {
+        const __m128i qx1 = _mm_set1_epi32(q.x1), qy1 = _mm_set1_epi32(q.y1);
+        const __m128i qx2 = _mm_set1_epi32(q.x2), qy2 = _mm_set1_epi32(q.y2);
+        const __m128i zero = _mm_setzero_si128();
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            __m128i bx1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(x1s + i));
+            __m128i by1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(y1s + i));
+            __m128i bx2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(x2s + i));
+            __m128i by2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(y2s + i));
+            __m128i lenX = _mm_max_epi32(_mm_sub_epi32(_mm_max_epi32(qx1, bx1), _mm_min_epi32(qx2, bx2)), zero);
+            __m128i lenY = _mm_max_epi32(_mm_sub_epi32(_mm_max_epi32(qy1, by1), _mm_min_epi32(qy2, by2)), zero);
+            store128(distances + i, _mm_add_epi64(widenLower128(lenX), widenLower128(lenY)),
+                     _mm_add_epi64(widenUpper128(lenX), widenUpper128(lenY)));
+        }
+        getDistanceScalar(q, x1s + i, y1s + i, x2s + i, y2s + i, n - i, distances + i);
+    }
+
+    __attribute__((target("sse4.1"))) void getParallelLengthSse(const geometry::CompactRectangle &q, const int32_t *x1s, const int32_t *y1s,
+                                                                const int32_t *x2s, const int32_t *y2s, size_t n, int64_t *lengths)
+    {
+        const __m128i qx1 = _mm_set1_epi32(q.x1), qy1 = _mm_set1_epi32(q.y1);
+        const __m128i qx2 = _mm_set1_epi32(q.x2), qy2 = _mm_set1_epi32(q.y2);
+        const __m128i zero = _mm_setzero_si128();
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            __m128i bx1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(x1s + i));
+            __m128i by1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(y1s + i));
+            __m128i bx2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(x2s + i));
+            __m128i by2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(y2s + i));
+            __m128i lenX = _mm_sub_epi32(_mm_min_epi32(qx2, bx2), _mm_max_epi32(qx1, bx1));
+            __m128i lenY = _mm_sub_epi32(_mm_min_epi32(qy2, by2), _mm_max_epi32(qy1, by1));
+            __m128i isX = _mm_cmpgt_epi32(lenX, zero);
+            __m128i isY = _mm_cmpgt_epi32(lenY, zero);
+            __m128i len = _mm_or_si128(_mm_and_si128(_mm_andnot_si128(isY, isX), lenX),
+                                       _mm_and_si128(_mm_andnot_si128(isX, isY), lenY));
+            store128(lengths + i, widenLower128(len), widenUpper128(len));
+        }
+        getParallelLengthScalar(q, x1s + i, y1s + i, x2s + i, y2s + i, n - i, lengths + i);
+    }
+#endif
+
+    struct Kernels
+    {
+        const char *name;
+        IntersectKernel selectIntersect;
+        MeasureKernel getDistance;
+        MeasureKernel getParallelLength;
+    };
+
+    // the kernels supported by the CPU, fastest first
+    std::vector<Kernels> getSupportedKernels()
+    {
+        std::vector<Kernels> kernels;
+#ifdef RECTANGLE_BATCH_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            kernels.push_back({"AVX2", selectIntersectAvx2, getDistanceAvx2, getParallelLengthAvx2});
+        if (__builtin_cpu_supports("sse4.1"))
+            kernels.push_back({"SSE4.1", selectIntersectSse, getDistanceSse, getParallelLengthSse});
+#endif
+        kernels.push_back({"scalar", selectIntersectScalar, getDistanceScalar, getParallelLengthScalar});
+        return kernels;
+    }
+
+    Kernels &getKernels()
+    {
+        static Kernels kernels = getSupportedKernels().front();
+        return kernels;
+    }
+}
+
+size_t geometry::RectangleBatch::size() const
+{
+    return x1s.size();
+}
+
+void geometry::RectangleBatch::clear()
+{
+    x1s.clear();
+    y1s.clear();
+    x2s.clear();
+    y2s.clear();
+}
+
+void geometry::RectangleBatch::reserve(size_t n)
+{
+    x1s.reserve(n);
+    y1s.reserve(n);
+    x2s.reserve(n);
+    y2s.reserve(n);
+}
+
+void geometry::RectangleBatch::emplace_back(const geometry::CompactRectangle &rectangle)
+{
+    x1s.emplace_back(rectangle.x1);
+    y1s.emplace_back(rectangle.y1);
+    x2s.emplace_back(rectangle.x2);
+    y2s.emplace_back(rectangle.y2);
+}
+
+geometry::CompactRectangle geometry::RectangleBatch::operator[](size_t idx) const
+{
+    return geometry::CompactRectangle(x1s[idx], y1s[idx], x2s[idx], y2s[idx]);
+}
+
+void geometry::RectangleBatch::selectIntersect(const geometry::CompactRectangle &query, std::vector<uint32_t> &indices) const
+{
+    getKernels().selectIntersect(query, x1s.data(), y1s.data(), x2s.data(), y2s.data(), size(), indices);
+}
+
+void geometry::RectangleBatch::getDistance(const geometry::CompactRectangle &query, std::vector<int64_t> &distances) const
+{
+    distances.resize(size());
+    getKernels().getDistance(query, x1s.data(), y1s.data(), x2s.data(), y2s.data(), size(), distances.data());
+}
+
+void geometry::RectangleBatch::getParallelLength(const geometry::CompactRectangle &query, std::vector<int64_t> &lengths) const
+{
+    lengths.resize(size());
+    getKernels().getParallelLength(query, x1s.data(), y1s.data(), x2s.data(), y2s.data(), size(), lengths.data());
+}
+
+const char *geometry::RectangleBatch::getKernelName()
+{
+    return getKernels().name;
+}
+
+std::vector<std::string> geometry::RectangleBatch::getSupportedKernelNames()
+{
+    std::vector<std::string> names;
+    for (const Kernels &kernels : getSupportedKernels())
+        names.emplace_back(kernels.name);
+    return names;
+}
+
+bool geometry::RectangleBatch::setKernel(const std::string &name)
+{
+    for (const Kernels &kernels : getSupportedKernels())
+    {
+        if (name == kernels.name)
+        {
+            getKernels() = kernels;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include "Geometry.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace geometry
+{
+    // Rectangles stored as structure-of-arrays of 32-bit coordinates, so that
+    // one query rectangle can be tested against many candidates with SIMD
+    // kernels. The kernel (AVX2, SSE4.1 or scalar) is chosen at runtime from
+    // the CPU features.
+    struct RectangleBatch
+    {
+        using ptr = std::unique_ptr<RectangleBatch>;
+
+        std::vector<int32_t> x1s, y1s, x2s, y2s;
+
+        size_t size() const;
+        void clear();
+        void reserve(size_t n);
+        void emplace_back(const CompactRectangle &rectangle);
+        CompactRectangle operator[](size_t idx) const;
+
+        // append the indices of the rectangles intersecting the query to indices
+        void selectIntersect(const CompactRectangle &query, std::vector<uint32_t> &indices) const;
+        // same as getDistance(query, rectangle) for every rectangle
+        void getDistance(const CompactRectangle &query, std::vector<int64_t> &distances) const;
+        // same as getParallelLength(query, rectangle) for every rectangle
+        void getParallelLength(const CompactRectangle &query, std::vector<int64_t> &lengths) const;
+
+        static const char *getKernelName();
+        // for testing every kernel on one machine; switch before the batches are used by other threads
+        static std::vector<std::string> getSupportedKernelNames();
+        static bool setKernel(const std::string &name); // false if the CPU does not support it
+    };
+}
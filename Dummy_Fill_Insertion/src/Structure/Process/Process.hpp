@@ -1,6 +1,8 @@
 #pragma once
 #include "../Geometry/Geometry.hpp"
+#include "../Geometry/RectangleBatch.hpp"
 #include "../Raw/Raw.hpp"
+#include <atomic>
 #include <memory>
 #include <string>
 #include <unordered_set>
@@ -8,20 +10,40 @@
 
 namespace process
 {
-    struct Conductor : geometry::Rectangle
+    // Conductors of a layer stored as structure-of-arrays. A conductor is
+    // referred to by its 32-bit index in the store.
+    struct ConductorStore : geometry::RectangleBatch
     {
-        using ptr = std::unique_ptr<Conductor>;
+        using ptr = std::unique_ptr<ConductorStore>;
 
-        int64_t netId;
-        bool isCritical;
+        std::vector<int64_t> netIds;
+        std::vector<bool> isCriticals; // one bit per conductor
 
-        Conductor() : netId(0), isCritical(false) {}
-        Conductor(const raw::Conductor *conductor) : netId(conductor->netId), isCritical(false)
+        void clear()
         {
-            x1 = conductor->x1;
-            y1 = conductor->y1;
-            x2 = conductor->x2;
-            y2 = conductor->y2;
+            geometry::RectangleBatch::clear();
+            netIds.clear();
+            isCriticals.clear();
+        }
+        void reserve(size_t n)
+        {
+            geometry::RectangleBatch::reserve(n);
+            netIds.reserve(n);
+            isCriticals.reserve(n);
+        }
+        void emplace_back(const geometry::CompactRectangle &conductor, int64_t netId, bool isCritical)
+        {
+            geometry::RectangleBatch::emplace_back(conductor);
+            netIds.emplace_back(netId);
+            isCriticals.emplace_back(isCritical);
+        }
+        bool empty() const
+        {
+            return netIds.empty();
+        }
+        bool isCritical(uint32_t idx) const
+        {
+            return isCriticals[idx];
         }
     };
 
@@ -39,7 +61,8 @@ namespace process
         int64_t id, minFillWidth, maxFillWidth, minSpacing;
         double minMetalDensity, maxMetalDensity, weight;
         Direction direction;
-        std::vector<Conductor::ptr> conductors;
+        ConductorStore conductors;
+        std::vector<geometry::CompactRectangle> previousFillers, changedRegions; // for incremental (ECO) mode
 
         Layer() : minFillWidth(0), maxFillWidth(0), minSpacing(0),
                   minMetalDensity(0), maxMetalDensity(0), weight(0), direction(Direction::NONE) {}
@@ -69,41 +92,105 @@ namespace process
     {
         using ptr = std::unique_ptr<Database>;
 
-        geometry::Rectangle chipBoundary;
+        geometry::CompactRectangle chipBoundary;   // relative to the origin, the lower-left corner is (0, 0)
+        geometry::CompactRectangle windowBoundary; // density windows are checked inside only
+        int64_t originX, originY;                // lower-left corner of the chip in the input coordinates
         int64_t windowSize;
+        bool isIncremental; // reuse previous fillers and re-solve around changed regions only
+        bool isPartial;     // a stripe of a larger chip, never re-solved as a whole
         std::vector<Layer::ptr> layers;
 
-        Database() : windowSize(0) {}
+        Database() : originX(0), originY(0), windowSize(0), isIncremental(false), isPartial(false) {}
+
+        // convert the input coordinates to the chip-relative solver coordinates
+        geometry::CompactRectangle toRelative(const geometry::Rectangle &rectangle) const
+        {
+            return geometry::CompactRectangle(geometry::Rectangle(rectangle).shift(-originX, -originY));
+        }
     };
 
-    struct Filler : geometry::Rectangle
+    struct Filler : geometry::CompactRectangle
     {
         using ptr = std::unique_ptr<Filler>;
 
         double cost;
-        bool inTile;
+        bool inTile, isFixed;
+        std::atomic<bool> inserted; // changed by compare-and-swap only
 
-        Filler() : cost(0), inTile(false) {}
-        Filler(const geometry::Rectangle &rectangle, bool inTile_) : cost(0), inTile(inTile_)
+        Filler() : cost(0), inTile(false), isFixed(false), inserted(false) {}
+        Filler(const geometry::CompactRectangle &rectangle, bool inTile_) : cost(0), inTile(inTile_), isFixed(false), inserted(false)
         {
             x1 = rectangle.x1;
             y1 = rectangle.y1;
             x2 = rectangle.x2;
             y2 = rectangle.y2;
         }
+
+        bool isInserted() const
+        {
+            return inserted.load(std::memory_order_acquire);
+        }
+        // true if this call changed the state, so a filler is committed once even if threads race on it
+        bool tryInsert()
+        {
+            bool expected = false;
+            return inserted.compare_exchange_strong(expected, true, std::memory_order_acq_rel);
+        }
+        bool tryRemove()
+        {
+            bool expected = true;
+            return inserted.compare_exchange_strong(expected, false, std::memory_order_acq_rel);
+        }
     };
 
-    struct Tile : geometry::Rectangle
+    // Area accumulator that several threads can add to at once. Copying is
+    // not atomic, so a grid of them is only resized by one thread.
+    struct AtomicArea
+    {
+        std::atomic<int64_t> value;
+
+        AtomicArea(int64_t value_ = 0) : value(value_) {}
+        AtomicArea(const AtomicArea &area) : value(area.load()) {}
+        AtomicArea &operator=(const AtomicArea &area)
+        {
+            store(area.load());
+            return *this;
+        }
+
+        int64_t load() const
+        {
+            return value.load(std::memory_order_relaxed);
+        }
+        void store(int64_t area)
+        {
+            value.store(area, std::memory_order_relaxed);
+        }
+        void add(int64_t area)
+        {
+            value.fetch_add(area, std::memory_order_relaxed);
+        }
+    };
+
+    struct Tile : geometry::CompactRectangle
     {
         using ptr = std::unique_ptr<Tile>;
 
-        int64_t conductorArea, fillerArea;
-        std::vector<int64_t *> windows;
-        std::vector<Conductor *> conductors;
-        std::vector<geometry::Rectangle *> candidateRegions;
+        enum class Kind
+        {
+            EMPTY = 0, // no conductor in the tile
+            FULL,      // covered by one conductor, nothing can be filled
+            MIXED
+        };
+
+        Kind kind;
+        int64_t conductorArea;
+        AtomicArea fillerArea;
+        bool isDirty; // fillers in the tile can be changed
+        std::vector<uint32_t> conductors; // indices in the conductor store of the layer
+        std::vector<geometry::CompactRectangle *> candidateRegions;
         std::unordered_set<Filler *> candidateFillerSet, fillerSet;
 
-        Tile() : conductorArea(0), fillerArea(0) {}
+        Tile() : kind(Kind::MIXED), conductorArea(0), fillerArea(0), isDirty(true) {}
         void setCoordinates(int64_t x1_, int64_t y1_, int64_t x2_, int64_t y2_)
         {
             x1 = x1_;
@@ -113,7 +200,7 @@ namespace process
         }
         int64_t occupyArea() const
         {
-            return conductorArea + fillerArea;
+            return conductorArea + fillerArea.load();
         }
         double density() const
         {
@@ -123,14 +210,14 @@ namespace process
 
     namespace sweepline
     {
-        struct Region : geometry::Rectangle
+        struct Region : geometry::CompactRectangle
         {
             using ptr = std::unique_ptr<Region>;
 
             bool isLegal;
 
             Region() : isLegal(true) {}
-            Region(const geometry::Rectangle &rectangle, bool isLegal)
+            Region(const geometry::CompactRectangle &rectangle, bool isLegal)
                 : isLegal(isLegal)
             {
                 x1 = rectangle.x1;
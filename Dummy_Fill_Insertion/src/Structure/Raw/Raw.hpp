@@ -23,4 +23,13 @@ namespace raw
 
         Conductor() : id(0), netId(0), layerId(0) {}
     };
+
+    struct Filler : geometry::Rectangle
+    {
+        using ptr = std::unique_ptr<Filler>;
+
+        int64_t layerId;
+
+        Filler() : layerId(0) {}
+    };
 }
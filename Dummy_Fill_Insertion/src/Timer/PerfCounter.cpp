@@ -0,0 +1,95 @@
+#include "PerfCounter.hpp"
+#include <cerrno>
+#include <cstring>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+PerfCounter::PerfCounter()
+{
+    fds.fill(-1);
+}
+
+PerfCounter::~PerfCounter()
+{
+    close();
+}
+
+const char *PerfCounter::getEventName(Event event)
+{
+    static const char *names[NUM_EVENT] = {"cycles", "instructions", "L1D misses", "LLC misses", "branch misses"};
+    return names[event];
+}
+
+bool PerfCounter::open(std::string &error)
+{
+    close();
+#ifdef __linux__
+    auto getCacheConfig = [](uint64_t cache) -> uint64_t
+    {
+        return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    };
+    const std::pair<uint32_t, uint64_t> eventConfigs[NUM_EVENT] = {
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HW_CACHE, getCacheConfig(PERF_COUNT_HW_CACHE_L1D)},
+        {PERF_TYPE_HW_CACHE, getCacheConfig(PERF_COUNT_HW_CACHE_LL)},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}};
+
+    int lastErrno = 0;
+    for (size_t event = 0; event < NUM_EVENT; ++event)
+    {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = eventConfigs[event].first;
+        attr.config = eventConfigs[event].second;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fds[event] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0); // this thread, any CPU
+        if (fds[event] < 0)
+            lastErrno = errno;
+    }
+    if (!isOpen())
+        error = std::string("perf_event_open: ") + std::strerror(lastErrno);
+    return isOpen();
+#else
+    error = "perf_event_open is only available on Linux";
+    return false;
+#endif
+}
+
+void PerfCounter::close()
+{
+#ifdef __linux__
+    for (int &fd : fds)
+        if (fd >= 0)
+            ::close(fd);
+#endif
+    fds.fill(-1);
+}
+
+bool PerfCounter::isOpen() const
+{
+    for (int fd : fds)
+        if (fd >= 0)
+            return true;
+    return false;
+}
+
+bool PerfCounter::isAvailable(Event event) const
+{
+    return fds[event] >= 0;
+}
+
+void PerfCounter::read(Values &values) const
+{
+    values.fill(0);
+#ifdef __linux__
+    for (size_t event = 0; event < NUM_EVENT; ++event)
+        if (fds[event] >= 0 && ::read(fds[event], &values[event], sizeof(uint64_t)) != sizeof(uint64_t))
+            values[event] = 0;
+#endif
+}
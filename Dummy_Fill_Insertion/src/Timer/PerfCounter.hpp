@@ -0,0 +1,40 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+
+// Hardware performance counters of the calling thread through Linux
+// perf_event_open (user space only, so perf_event_paranoid <= 2 suffices).
+// Every event is opened on its own, so an event the CPU or the kernel does
+// not offer is reported as unavailable while the others still count.
+class PerfCounter
+{
+public:
+    enum Event
+    {
+        CYCLES = 0,
+        INSTRUCTIONS,
+        L1D_MISSES,
+        LLC_MISSES,
+        BRANCH_MISSES,
+        NUM_EVENT
+    };
+    using Values = std::array<uint64_t, NUM_EVENT>;
+
+private:
+    std::array<int, NUM_EVENT> fds;
+
+public:
+    PerfCounter();
+    ~PerfCounter();
+    PerfCounter(const PerfCounter &) = delete;
+    PerfCounter &operator=(const PerfCounter &) = delete;
+
+    static const char *getEventName(Event event);
+    // false with the reason if no event can be counted
+    bool open(std::string &error);
+    void close();
+    bool isOpen() const;
+    bool isAvailable(Event event) const;
+    void read(Values &values) const; // 0 for the unavailable events
+};
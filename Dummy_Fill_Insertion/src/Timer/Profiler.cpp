@@ -0,0 +1,288 @@
+#include "Profiler.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+
+namespace
+{
+    const auto startTime = std::chrono::steady_clock::now();
+}
+
+std::mutex Profiler::registryMutex;
+std::vector<std::string> Profiler::zoneNames;
+std::vector<std::unique_ptr<Profiler::ThreadLog>> Profiler::threadLogs;
+std::vector<Profiler::ThreadLog *> Profiler::freeThreadLogs;
+bool Profiler::isCounting = false;
+
+Profiler::ThreadLog::ThreadLog(size_t threadIdx_)
+    : threadIdx(threadIdx_), nodes(1, Node{0, noArg, 0, {}, 0, 0, {}}), currentIdx(0), events(maxNumEvent), numEvent(0)
+{
+    isCounted.fill(false);
+}
+
+Profiler::ThreadLog &Profiler::getThreadLog()
+{
+    // the logs outlive their threads, so the worker threads can be reported after joining
+    struct Holder
+    {
+        ThreadLog *log = nullptr;
+        ~Holder()
+        {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            if (log)
+            {
+                log->perfCounter.close();
+                freeThreadLogs.emplace_back(log);
+            }
+        }
+    };
+    static thread_local Holder holder;
+    if (!holder.log)
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        if (!freeThreadLogs.empty())
+        {
+            holder.log = freeThreadLogs.back();
+            freeThreadLogs.pop_back();
+        }
+        else
+        {
+            threadLogs.emplace_back(new ThreadLog(threadLogs.size()));
+            holder.log = threadLogs.back().get();
+        }
+        if (isCounting)
+            openCounters(*holder.log); // the counters follow the thread, not the log
+    }
+    return *holder.log;
+}
+
+void Profiler::openCounters(ThreadLog &log)
+{
+    std::string error;
+    if (!log.perfCounter.open(error) && log.threadIdx == 0)
+        std::cout << "[Warning] Hardware counters are unavailable (" << error << "), only the time is profiled.\n";
+    for (size_t event = 0; event < PerfCounter::NUM_EVENT; ++event)
+        log.isCounted[event] = log.isCounted[event] || log.perfCounter.isAvailable(static_cast<PerfCounter::Event>(event));
+}
+
+bool Profiler::enableCounters()
+{
+    ThreadLog &log = getThreadLog();
+    isCounting = true;
+    openCounters(log);
+    isCounting = log.perfCounter.isOpen();
+    return isCounting;
+}
+
+int64_t Profiler::getNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+std::string Profiler::getNodeName(const Node &node)
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    std::string name = zoneNames[node.zoneId];
+    if (node.arg != noArg)
+        name += " " + std::to_string(node.arg);
+    return name;
+}
+
+Profiler::Scope::Scope(ZoneId zoneId, int64_t arg) : log(getThreadLog()), parentIdx(log.currentIdx)
+{
+    std::vector<uint32_t> &childIdxs = log.nodes[parentIdx].childIdxs;
+    auto it = std::find_if(childIdxs.begin(), childIdxs.end(), [&](uint32_t childIdx) -> bool
+                           { return log.nodes[childIdx].zoneId == zoneId && log.nodes[childIdx].arg == arg; });
+    if (it != childIdxs.end())
+        nodeIdx = *it;
+    else
+    {
+        nodeIdx = log.nodes.size();
+        log.nodes[parentIdx].childIdxs.emplace_back(nodeIdx);
+        log.nodes.push_back(Node{zoneId, arg, parentIdx, {}, 0, 0, {}});
+    }
+    log.currentIdx = nodeIdx;
+    if (log.perfCounter.isOpen())
+        log.perfCounter.read(beginCounters);
+    beginNs = getNs();
+}
+
+Profiler::Scope::~Scope()
+{
+    int64_t endNs = getNs();
+    Node &node = log.nodes[nodeIdx];
+    if (log.perfCounter.isOpen())
+    {
+        PerfCounter::Values endCounters;
+        log.perfCounter.read(endCounters);
+        for (size_t event = 0; event < PerfCounter::NUM_EVENT; ++event)
+            node.counters[event] += endCounters[event] - beginCounters[event];
+    }
+    node.totalNs += endNs - beginNs;
+    ++node.numCall;
+    log.events[log.numEvent % maxNumEvent] = Event{node.zoneId, node.arg, beginNs, endNs};
+    ++log.numEvent;
+    log.currentIdx = parentIdx;
+}
+
+Profiler::ZoneId Profiler::getZoneId(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    auto it = std::find(zoneNames.begin(), zoneNames.end(), name);
+    if (it != zoneNames.end())
+        return it - zoneNames.begin();
+    zoneNames.emplace_back(name);
+    return zoneNames.size() - 1;
+}
+
+double Profiler::getSecond(const std::string &path)
+{
+    const ThreadLog &log = getThreadLog();
+    uint32_t nodeIdx = 0;
+    std::stringstream pathStream(path);
+    std::string name;
+    while (std::getline(pathStream, name, '/'))
+    {
+        const std::vector<uint32_t> &childIdxs = log.nodes[nodeIdx].childIdxs;
+        auto it = std::find_if(childIdxs.begin(), childIdxs.end(), [&](uint32_t childIdx) -> bool
+                               { return getNodeName(log.nodes[childIdx]) == name; });
+        if (it == childIdxs.end())
+            return 0;
+        nodeIdx = *it;
+    }
+    return log.nodes[nodeIdx].totalNs / 1e9;
+}
+
+void Profiler::printNode(std::ostream &output, const ThreadLog &log, uint32_t nodeIdx, size_t depth)
+{
+    const Node &node = log.nodes[nodeIdx];
+    char line[128];
+    std::string name = std::string(2 * depth, ' ') + getNodeName(node);
+    std::snprintf(line, sizeof(line), "%-38s%12.4lf%10zu\n", name.c_str(), node.totalNs / 1e9, node.numCall);
+    output << line;
+    for (uint32_t childIdx : node.childIdxs)
+        printNode(output, log, childIdx, depth + 1);
+}
+
+void Profiler::printBreakdown(std::ostream &output)
+{
+    std::vector<const ThreadLog *> logs;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (const std::unique_ptr<ThreadLog> &log : threadLogs)
+            logs.emplace_back(log.get());
+    }
+
+    char line[128];
+    output << "----- PROFILE -----\n";
+    std::snprintf(line, sizeof(line), "%-38s%12s%10s\n", "zone", "total(s)", "#calls");
+    output << line;
+    for (const ThreadLog *log : logs)
+    {
+        if (log->threadIdx > 0)
+            output << "(thread " << log->threadIdx << ")\n";
+        for (uint32_t childIdx : log->nodes[0].childIdxs)
+            printNode(output, *log, childIdx, 0);
+    }
+    output << "\n";
+}
+
+void Profiler::printCounterNode(std::ostream &output, const ThreadLog &log, uint32_t nodeIdx, size_t depth)
+{
+    const Node &node = log.nodes[nodeIdx];
+    char line[256];
+    std::string name = std::string(2 * depth, ' ') + getNodeName(node);
+    int length = std::snprintf(line, sizeof(line), "%-38s", name.c_str());
+    for (size_t event = 0; event < PerfCounter::NUM_EVENT; ++event)
+    {
+        if (log.isCounted[event])
+            length += std::snprintf(line + length, sizeof(line) - length, "%15.3lf", node.counters[event] / 1e6);
+        else
+            length += std::snprintf(line + length, sizeof(line) - length, "%15s", "n/a");
+    }
+    uint64_t cycles = node.counters[PerfCounter::CYCLES];
+    if (cycles > 0 && log.isCounted[PerfCounter::INSTRUCTIONS])
+        std::snprintf(line + length, sizeof(line) - length, "%8.2lf\n", static_cast<double>(node.counters[PerfCounter::INSTRUCTIONS]) / cycles);
+    else
+        std::snprintf(line + length, sizeof(line) - length, "%8s\n", "n/a");
+    output << line;
+    for (uint32_t childIdx : node.childIdxs)
+        printCounterNode(output, log, childIdx, depth + 1);
+}
+
+void Profiler::printCounters(std::ostream &output)
+{
+    if (!isCounting)
+        return;
+    std::vector<const ThreadLog *> logs;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (const std::unique_ptr<ThreadLog> &log : threadLogs)
+            logs.emplace_back(log.get());
+    }
+
+    char line[256];
+    int length = std::snprintf(line, sizeof(line), "%-38s", "zone (millions)");
+    for (size_t event = 0; event < PerfCounter::NUM_EVENT; ++event)
+        length += std::snprintf(line + length, sizeof(line) - length, "%15s", PerfCounter::getEventName(static_cast<PerfCounter::Event>(event)));
+    std::snprintf(line + length, sizeof(line) - length, "%8s\n", "IPC");
+    output << "----- HARDWARE COUNTERS -----\n"
+           << line;
+    for (const ThreadLog *log : logs)
+    {
+        if (log->threadIdx > 0)
+            output << "(thread " << log->threadIdx << ")\n";
+        for (uint32_t childIdx : log->nodes[0].childIdxs)
+            printCounterNode(output, *log, childIdx, 0);
+    }
+    output << "\n";
+}
+
+bool Profiler::writeTrace(const std::string &filepath)
+{
+    std::ofstream fout(filepath);
+    if (!fout)
+    {
+        std::cerr << "[Error] Cannot open \"" << filepath << "\".\n";
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    auto toJsonString = [](const std::string &str) -> std::string
+    {
+        std::string escaped = "\"";
+        for (char c : str)
+        {
+            if (c == '"' || c == '\\')
+                escaped += '\\';
+            escaped += c;
+        }
+        return escaped + "\"";
+    };
+
+    // complete events ("X") in microseconds, one trace thread per profiler thread
+    bool isFirst = true;
+    fout << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    for (const std::unique_ptr<ThreadLog> &logPtr : threadLogs)
+    {
+        const ThreadLog &log = *logPtr;
+        if (log.numEvent > maxNumEvent)
+            std::cout << "[Warning] The trace of thread " << log.threadIdx << " keeps only its last " << maxNumEvent << " of "
+                      << log.numEvent << " events.\n";
+        for (size_t eventIdx = (log.numEvent > maxNumEvent) ? log.numEvent - maxNumEvent : 0; eventIdx < log.numEvent; ++eventIdx)
+        {
+            const Event &event = log.events[eventIdx % maxNumEvent];
+            fout << (isFirst ? "" : ",") << "\n{\"name\": " << toJsonString(zoneNames[event.zoneId]) << ", \"ph\": \"X\", \"pid\": 1, \"tid\": "
+                 << log.threadIdx << ", \"ts\": " << event.beginNs / 1000.0 << ", \"dur\": " << (event.endNs - event.beginNs) / 1000.0;
+            if (event.arg != noArg)
+                fout << ", \"args\": {\"arg\": " << event.arg << "}";
+            fout << "}";
+            isFirst = false;
+        }
+    }
+    fout << "\n]}\n";
+    return static_cast<bool>(fout);
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include "PerfCounter.hpp"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Hierarchical profiler of nested RAII zones, cheap enough to stay on.
+// A zone name is registered once per call site (PROFILE_ZONE keeps the id in
+// a function-local static), so entering a zone only reads the clock and
+// looks the zone up among the few children of the current one. Each thread
+// accumulates its own call tree and keeps its last events in a ring buffer,
+// nothing is shared on the hot path. The trees give the per-layer,
+// per-phase breakdown, the events a Chrome trace (chrome://tracing, Perfetto).
+// With the hardware counters enabled, every zone also accumulates the counter
+// deltas of its thread, at the cost of a few read() calls per zone.
+class Profiler
+{
+public:
+    using ZoneId = uint32_t;
+
+private:
+    static constexpr size_t maxNumEvent = 1 << 16; // per thread, the oldest events are overwritten
+    static constexpr int64_t noArg = INT64_MIN;
+
+    struct Node
+    {
+        ZoneId zoneId;
+        int64_t arg;
+        uint32_t parentIdx;
+        std::vector<uint32_t> childIdxs;
+        int64_t totalNs;
+        size_t numCall;
+        PerfCounter::Values counters;
+    };
+
+    struct Event
+    {
+        ZoneId zoneId;
+        int64_t arg, beginNs, endNs;
+    };
+
+    struct ThreadLog
+    {
+        size_t threadIdx;
+        std::vector<Node> nodes; // node 0 is the root
+        uint32_t currentIdx;
+        std::vector<Event> events;
+        size_t numEvent; // ever recorded, the ring holds the last maxNumEvent
+        PerfCounter perfCounter; // opened by the thread using the log, if counting
+        std::array<bool, PerfCounter::NUM_EVENT> isCounted; // by any thread that used the log
+
+        ThreadLog(size_t threadIdx_);
+    };
+
+    // only touched when a zone or a thread is new and on reporting; the log of an ended thread is
+    // reused by the next new thread, so short-lived worker threads do not pile up ring buffers
+    static std::mutex registryMutex;
+    static std::vector<std::string> zoneNames;
+    static std::vector<std::unique_ptr<ThreadLog>> threadLogs;
+    static std::vector<ThreadLog *> freeThreadLogs;
+    static bool isCounting; // set before any worker thread starts
+
+    static ThreadLog &getThreadLog();
+    static int64_t getNs();
+    static std::string getNodeName(const Node &node);
+    static void printNode(std::ostream &output, const ThreadLog &log, uint32_t nodeIdx, size_t depth);
+    static void printCounterNode(std::ostream &output, const ThreadLog &log, uint32_t nodeIdx, size_t depth);
+    static void openCounters(ThreadLog &log);
+
+public:
+    class Scope
+    {
+        ThreadLog &log;
+        uint32_t parentIdx, nodeIdx;
+        int64_t beginNs;
+        PerfCounter::Values beginCounters;
+
+    public:
+        // the argument (e.g. a layer id) tells calls of the same zone apart in the breakdown
+        Scope(ZoneId zoneId, int64_t arg = noArg);
+        ~Scope();
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+    };
+
+    static ZoneId getZoneId(const std::string &name);
+    // counts the hardware events in the zones entered from now on; false (with a warning) if no counter can be opened
+    static bool enableCounters();
+    static double getSecond(const std::string &path); // total of a zone path of the calling thread, e.g. "runtime/parse input"
+    static void printBreakdown(std::ostream &output);
+    static void printCounters(std::ostream &output);
+    static bool writeTrace(const std::string &filepath);
+};
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+// PROFILE_ZONE("name") or PROFILE_ZONE("name", arg) profiles the rest of the enclosing block
+#define PROFILE_ZONE(name, ...)                                                                          \
+    static const Profiler::ZoneId PROFILE_CONCAT(profileZoneId, __LINE__) = Profiler::getZoneId(name); \
+    Profiler::Scope PROFILE_CONCAT(profileScope, __LINE__)(PROFILE_CONCAT(profileZoneId, __LINE__), ##__VA_ARGS__)
@@ -0,0 +1,224 @@
+#include "Progress.hpp"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <pthread.h>
+
+std::mutex Progress::registryMutex;
+std::vector<std::unique_ptr<Progress::Slot>> Progress::slots;
+std::vector<Progress::Slot *> Progress::freeSlots;
+bool Progress::isEnabled = false;
+
+std::mutex Progress::phaseMutex;
+Progress::PhaseState Progress::phaseState{"", Progress::noLayer, 0, {}, nullptr};
+Progress::MinMaxDensity Progress::lastMinMaxDensity(-1, -1);
+
+std::chrono::milliseconds Progress::interval(1000);
+bool Progress::isPrinting = false;
+std::string Progress::statusFilepath;
+std::thread Progress::reporter;
+std::condition_variable Progress::stopCondition;
+bool Progress::isStopping = false;
+std::chrono::steady_clock::time_point Progress::startTime;
+
+Progress::Slot::Slot()
+{
+    for (std::atomic<uint64_t> &count : counts)
+        count.store(0, std::memory_order_relaxed);
+}
+
+Progress::Slot &Progress::getSlot()
+{
+    struct Holder
+    {
+        Slot *slot = nullptr;
+        ~Holder()
+        {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            if (slot)
+                freeSlots.emplace_back(slot);
+        }
+    };
+    static thread_local Holder holder;
+    if (!holder.slot)
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        if (!freeSlots.empty())
+        {
+            holder.slot = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else
+        {
+            slots.emplace_back(new Slot());
+            holder.slot = slots.back().get();
+        }
+    }
+    return *holder.slot;
+}
+
+Progress::Sample Progress::takeSample()
+{
+    Sample sample{std::chrono::steady_clock::now(), {}};
+    sample.counts.fill(0);
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (const std::unique_ptr<Slot> &slot : slots)
+        for (size_t counter = 0; counter < NUM_COUNTER; ++counter)
+            sample.counts[counter] += slot->counts[counter].load(std::memory_order_relaxed);
+    return sample;
+}
+
+Progress::Phase::Phase(const std::string &name, int64_t layerId, uint64_t numTile, const std::function<MinMaxDensity()> &getMinMaxDensity)
+{
+    if (!isEnabled)
+        return;
+    Sample begin = takeSample();
+    std::lock_guard<std::mutex> lock(phaseMutex);
+    outerState = std::move(phaseState);
+    phaseState = PhaseState{name, layerId, numTile, begin, getMinMaxDensity};
+}
+
+Progress::Phase::~Phase()
+{
+    if (!isEnabled)
+        return;
+    // the density source may not outlive the phase, so keep its last value
+    std::lock_guard<std::mutex> lock(phaseMutex);
+    if (phaseState.getMinMaxDensity)
+        lastMinMaxDensity = phaseState.getMinMaxDensity();
+    phaseState = std::move(outerState);
+}
+
+void Progress::report(const Sample &previous, const Sample &current, bool isDone)
+{
+    std::string name;
+    int64_t layerId;
+    uint64_t numTile, numDoneTile;
+    double phaseSecond;
+    MinMaxDensity minMaxDensity;
+    {
+        std::lock_guard<std::mutex> lock(phaseMutex);
+        // the windows are atomic and not reallocated during a phase, so they can be read while the solver runs
+        if (phaseState.getMinMaxDensity)
+            lastMinMaxDensity = phaseState.getMinMaxDensity();
+        name = phaseState.name.empty() ? "-" : phaseState.name;
+        layerId = phaseState.layerId;
+        numTile = phaseState.numTile;
+        numDoneTile = current.counts[TILES] - phaseState.begin.counts[TILES];
+        phaseSecond = std::chrono::duration<double>(current.time - phaseState.begin.time).count();
+        minMaxDensity = lastMinMaxDensity;
+    }
+
+    double elapsedSecond = std::chrono::duration<double>(current.time - startTime).count();
+    double intervalSecond = std::chrono::duration<double>(current.time - previous.time).count();
+    double tilePerSecond = (intervalSecond > 0) ? (current.counts[TILES] - previous.counts[TILES]) / intervalSecond : 0;
+    // the ETA of the current phase from its average throughput so far
+    double etaSecond = -1;
+    if (numTile > 0 && numDoneTile > 0)
+        etaSecond = (numTile > numDoneTile) ? (numTile - numDoneTile) * phaseSecond / numDoneTile : 0;
+
+    if (isPrinting)
+    {
+        char line[256];
+        int length = std::snprintf(line, sizeof(line), "[Progress] %8.1lf s", elapsedSecond);
+        if (layerId != noLayer)
+            length += std::snprintf(line + length, sizeof(line) - length, ", layer %ld", static_cast<long>(layerId));
+        length += std::snprintf(line + length, sizeof(line) - length, ", %s", name.c_str());
+        if (numTile > 0)
+            length += std::snprintf(line + length, sizeof(line) - length, ", tiles %lu/%lu", static_cast<unsigned long>(numDoneTile),
+                                    static_cast<unsigned long>(numTile));
+        length += std::snprintf(line + length, sizeof(line) - length, ", %.0lf tiles/s, fillers +%lu -%lu", tilePerSecond,
+                                static_cast<unsigned long>(current.counts[INSERTED_FILLERS]), static_cast<unsigned long>(current.counts[REMOVED_FILLERS]));
+        if (minMaxDensity.first >= 0)
+            length += std::snprintf(line + length, sizeof(line) - length, ", density %.4lf %.4lf", minMaxDensity.first, minMaxDensity.second);
+        if (etaSecond >= 0)
+            length += std::snprintf(line + length, sizeof(line) - length, ", ETA %.1lf s", etaSecond);
+        std::cerr << line << "\n";
+    }
+
+    if (!statusFilepath.empty())
+    {
+        // written aside and renamed, so a monitor never reads a partial file
+        std::string tmpFilepath = statusFilepath + ".tmp";
+        {
+            std::ofstream fout(tmpFilepath);
+            if (!fout)
+                return;
+            fout << "{\"elapsed\": " << elapsedSecond << ", \"done\": " << (isDone ? "true" : "false") << ", \"phase\": \"" << name
+                 << "\", \"layer\": ";
+            if (layerId != noLayer)
+                fout << layerId;
+            else
+                fout << "null";
+            fout << ", \"tiles\": " << numDoneTile << ", \"phaseTiles\": " << numTile << ", \"tilesPerSecond\": " << tilePerSecond
+                 << ", \"insertedFillers\": " << current.counts[INSERTED_FILLERS] << ", \"removedFillers\": " << current.counts[REMOVED_FILLERS]
+                 << ", \"minDensity\": ";
+            if (minMaxDensity.first >= 0)
+                fout << minMaxDensity.first << ", \"maxDensity\": " << minMaxDensity.second;
+            else
+                fout << "null, \"maxDensity\": null";
+            fout << ", \"eta\": ";
+            if (etaSecond >= 0)
+                fout << etaSecond;
+            else
+                fout << "null";
+            fout << "}\n";
+        }
+        std::rename(tmpFilepath.c_str(), statusFilepath.c_str());
+    }
+}
+
+void Progress::run()
+{
+    Sample previous = takeSample();
+    std::unique_lock<std::mutex> lock(phaseMutex);
+    while (!stopCondition.wait_for(lock, interval, []() -> bool
+                                   { return isStopping; }))
+    {
+        lock.unlock();
+        Sample current = takeSample();
+        report(previous, current, false);
+        previous = current;
+        lock.lock();
+    }
+    lock.unlock();
+    report(previous, takeSample(), true);
+}
+
+bool Progress::start(std::chrono::milliseconds interval_, bool isPrinting_, const std::string &statusFilepath_)
+{
+    if (!statusFilepath_.empty() && !std::ofstream(statusFilepath_))
+    {
+        std::cerr << "[Error] Cannot open \"" << statusFilepath_ << "\".\n";
+        return false;
+    }
+    // a forked worker only inherits the calling thread, so it neither bumps nor waits for the reporter
+    static bool isAtForkRegistered = false;
+    if (!isAtForkRegistered)
+        pthread_atfork(nullptr, nullptr, []()
+                       { isEnabled = false; });
+    isAtForkRegistered = true;
+
+    interval = interval_;
+    isPrinting = isPrinting_;
+    statusFilepath = statusFilepath_;
+    startTime = std::chrono::steady_clock::now();
+    phaseState = PhaseState{"", noLayer, 0, takeSample(), nullptr};
+    isStopping = false;
+    isEnabled = true;
+    reporter = std::thread(run);
+    return true;
+}
+
+void Progress::stop()
+{
+    if (!reporter.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(phaseMutex);
+        isStopping = true;
+    }
+    stopCondition.notify_one();
+    reporter.join();
+    isEnabled = false;
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Live progress of the long passes. The hot loops only bump counters of their
+// own thread (no shared cache line, no lock), while a reporter thread sums
+// them at a fixed interval and prints a line to the standard error and/or
+// rewrites a status file. The running pass is named by a Phase, which also
+// tells the reporter its number of tiles for the ETA and how to read the
+// min/max window density. Disabled, a bump is a single branch.
+class Progress
+{
+public:
+    enum Counter
+    {
+        TILES,
+        INSERTED_FILLERS,
+        REMOVED_FILLERS,
+        NUM_COUNTER
+    };
+
+    using MinMaxDensity = std::pair<double, double>;
+    static constexpr int64_t noLayer = INT64_MIN;
+
+private:
+    struct alignas(64) Slot
+    {
+        std::array<std::atomic<uint64_t>, NUM_COUNTER> counts; // written by the owning thread only
+
+        Slot();
+    };
+
+    struct Sample
+    {
+        std::chrono::steady_clock::time_point time;
+        std::array<uint64_t, NUM_COUNTER> counts;
+    };
+
+    // the slot of an ended thread is reused by the next new thread, its counts are kept
+    static std::mutex registryMutex;
+    static std::vector<std::unique_ptr<Slot>> slots;
+    static std::vector<Slot *> freeSlots;
+    static bool isEnabled; // set before any worker thread starts, cleared in forked children
+
+    struct PhaseState
+    {
+        std::string name; // empty between the phases
+        int64_t layerId;
+        uint64_t numTile;
+        Sample begin;
+        std::function<MinMaxDensity()> getMinMaxDensity;
+    };
+
+    static std::mutex phaseMutex; // guards the phase state and the last density
+    static PhaseState phaseState;
+    static MinMaxDensity lastMinMaxDensity;
+
+    static std::chrono::milliseconds interval;
+    static bool isPrinting;
+    static std::string statusFilepath;
+    static std::thread reporter;
+    static std::condition_variable stopCondition;
+    static bool isStopping;
+    static std::chrono::steady_clock::time_point startTime;
+
+    static Slot &getSlot();
+    static Sample takeSample();
+    static void report(const Sample &previous, const Sample &current, bool isDone);
+    static void run();
+
+public:
+    // names the current phase until its end, when the enclosing phase (if any) is resumed
+    class Phase
+    {
+        PhaseState outerState;
+
+    public:
+        // numTile is the number of tiles the pass visits, 0 if it is not tile by tile (no ETA)
+        Phase(const std::string &name, int64_t layerId = noLayer, uint64_t numTile = 0,
+              const std::function<MinMaxDensity()> &getMinMaxDensity = nullptr);
+        ~Phase();
+        Phase(const Phase &) = delete;
+        Phase &operator=(const Phase &) = delete;
+    };
+
+    // starts the reporter, printing every interval if isPrinting_ and rewriting statusFilepath_ if not empty
+    static bool start(std::chrono::milliseconds interval_, bool isPrinting_, const std::string &statusFilepath_);
+    static void stop(); // joins the reporter after a last report
+
+    static void add(Counter counter, uint64_t count = 1)
+    {
+        if (!isEnabled)
+            return;
+        std::atomic<uint64_t> &value = getSlot().counts[counter];
+        value.store(value.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+    }
+};
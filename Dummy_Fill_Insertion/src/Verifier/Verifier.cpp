@@ -0,0 +1,314 @@
+#include "Verifier.hpp"
+#include "../DensityManager/DensityManager.hpp"
+#include "../Timer/Profiler.hpp"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+Verifier::Verifier(const process::Database *db_, size_t numThread_)
+    : db(db_), numThread(std::max<size_t>(numThread_, 1)),
+      tileSize(db->windowSize / DensityManager::numStepForWindow),
+      numTileRow(std::max<int64_t>(db->chipBoundary.height() / tileSize, 1)),
+      numTileCol(std::max<int64_t>(db->chipBoundary.width() / tileSize, 1)) {}
+
+std::tuple<size_t, size_t, size_t, size_t> Verifier::getTileRange(const geometry::CompactRectangle &rectangle, int64_t margin) const
+{
+    // rows/cols [begin, end), the rectangles outside the chip go to the border tiles
+    auto getIdx = [&](int64_t pos, size_t numTile) -> size_t
+    {
+        return std::clamp<int64_t>(pos / tileSize, 0, numTile - 1);
+    };
+    return {getIdx(rectangle.y1 - margin - db->chipBoundary.y1, numTileRow),
+            getIdx(rectangle.y2 + margin - 1 - db->chipBoundary.y1, numTileRow) + 1,
+            getIdx(rectangle.x1 - margin - db->chipBoundary.x1, numTileCol),
+            getIdx(rectangle.x2 + margin - 1 - db->chipBoundary.x1, numTileCol) + 1};
+}
+
+Verifier::TileIndex Verifier::buildIndex(const std::vector<geometry::CompactRectangle> &rectangles) const
+{
+    TileIndex index;
+    index.begins.assign(numTileRow * numTileCol + 1, 0);
+    for (const geometry::CompactRectangle &rectangle : rectangles)
+    {
+        auto [rowBegin, rowEnd, colBegin, colEnd] = getTileRange(rectangle, 0);
+        for (size_t rowIdx = rowBegin; rowIdx < rowEnd; ++rowIdx)
+            for (size_t colIdx = colBegin; colIdx < colEnd; ++colIdx)
+                ++index.begins[rowIdx * numTileCol + colIdx + 1];
+    }
+    for (size_t i = 1; i < index.begins.size(); ++i)
+        index.begins[i] += index.begins[i - 1];
+
+    std::vector<uint32_t> ends(index.begins.begin(), index.begins.end() - 1);
+    index.idxs.resize(index.begins.back());
+    for (size_t idx = 0; idx < rectangles.size(); ++idx)
+    {
+        auto [rowBegin, rowEnd, colBegin, colEnd] = getTileRange(rectangles[idx], 0);
+        for (size_t rowIdx = rowBegin; rowIdx < rowEnd; ++rowIdx)
+            for (size_t colIdx = colBegin; colIdx < colEnd; ++colIdx)
+                index.idxs[ends[rowIdx * numTileCol + colIdx]++] = idx;
+    }
+    return index;
+}
+
+std::string Verifier::toString(const geometry::CompactRectangle &rectangle) const
+{
+    return "(" + geometry::Rectangle(rectangle).shift(db->originX, db->originY).dumpCoordinates() + ")";
+}
+
+int64_t Verifier::getUnionArea(const std::vector<geometry::CompactRectangle> &rectangles)
+{
+    // sweep along x over the compressed y coordinates, a segment tree keeps the covered length
+    std::vector<int32_t> ys;
+    std::vector<std::tuple<int32_t, int, size_t>> events; // x, +1/-1, rectangle index
+    for (size_t idx = 0; idx < rectangles.size(); ++idx)
+    {
+        ys.emplace_back(rectangles[idx].y1);
+        ys.emplace_back(rectangles[idx].y2);
+        events.emplace_back(rectangles[idx].x1, 1, idx);
+        events.emplace_back(rectangles[idx].x2, -1, idx);
+    }
+    if (events.empty())
+        return 0;
+    std::sort(ys.begin(), ys.end());
+    ys.erase(std::unique(ys.begin(), ys.end()), ys.end());
+    std::sort(events.begin(), events.end());
+
+    size_t numSegment = ys.size() - 1;
+    std::vector<int> counts(4 * numSegment, 0);
+    std::vector<int64_t> lengths(4 * numSegment, 0);
+    std::function<void(size_t, size_t, size_t, size_t, size_t, int)> update =
+        [&](size_t node, size_t begin, size_t end, size_t queryBegin, size_t queryEnd, int delta)
+    {
+        if (queryEnd <= begin || end <= queryBegin)
+            return;
+        if (queryBegin <= begin && end <= queryEnd)
+            counts[node] += delta;
+        else
+        {
+            size_t mid = (begin + end) / 2;
+            update(2 * node, begin, mid, queryBegin, queryEnd, delta);
+            update(2 * node + 1, mid, end, queryBegin, queryEnd, delta);
+        }
+        if (counts[node] > 0)
+            lengths[node] = static_cast<int64_t>(ys[end]) - ys[begin];
+        else
+            lengths[node] = (end - begin > 1) ? lengths[2 * node] + lengths[2 * node + 1] : 0;
+    };
+
+    int64_t area = 0;
+    for (size_t i = 0; i < events.size(); ++i)
+    {
+        const auto &[x, delta, idx] = events[i];
+        if (i > 0)
+            area += lengths[1] * (static_cast<int64_t>(x) - std::get<0>(events[i - 1]));
+        size_t yBegin = std::lower_bound(ys.begin(), ys.end(), rectangles[idx].y1) - ys.begin();
+        size_t yEnd = std::lower_bound(ys.begin(), ys.end(), rectangles[idx].y2) - ys.begin();
+        if (numSegment > 0)
+            update(1, 0, numSegment, yBegin, yEnd, delta);
+    }
+    return area;
+}
+
+size_t Verifier::checkFiller(const process::Layer &layer, const std::vector<geometry::CompactRectangle> &fillers,
+                             std::vector<geometry::CompactRectangle> &placedFillers, std::ostream &output) const
+{
+    size_t numViolation = 0;
+    for (const geometry::CompactRectangle &filler : fillers)
+    {
+        bool isInside = filler.x1 >= db->chipBoundary.x1 && filler.y1 >= db->chipBoundary.y1 && filler.x2 <= db->chipBoundary.x2 && filler.y2 <= db->chipBoundary.y2;
+        if (!isInside)
+        {
+            output << "In layer " << layer.id << ", " << toString(filler) << " is out of boundary!\n";
+            ++numViolation;
+        }
+        if (filler.x1 >= filler.x2 || filler.y1 >= filler.y2)
+        {
+            output << "In layer " << layer.id << ", " << toString(filler) << "'s coordinate is illegal!\n";
+            ++numViolation;
+            continue;
+        }
+        if (geometry::isIntersect(filler, db->chipBoundary))
+            placedFillers.emplace_back(filler);
+        if (std::min(filler.width(), filler.height()) < layer.minFillWidth)
+        {
+            output << "In layer " << layer.id << ", " << toString(filler) << " violates minimum fill width constraint!\n";
+            ++numViolation;
+        }
+        if (std::max(filler.width(), filler.height()) > layer.maxFillWidth)
+        {
+            output << "In layer " << layer.id << ", " << toString(filler) << " violates maximum fill width constraint!\n";
+            ++numViolation;
+        }
+    }
+    return numViolation;
+}
+
+size_t Verifier::checkSpacing(const process::Layer &layer, const std::vector<geometry::CompactRectangle> &conductors,
+                              const std::vector<geometry::CompactRectangle> &fillers, const TileIndex &conductorIndex,
+                              const TileIndex &fillerIndex, std::ostream &output) const
+{
+    // the Manhattan distance between the nearest points, as the prebuilt verifier measures it
+    int64_t minSpacing = layer.minSpacing;
+    auto isTooClose = [&](const geometry::CompactRectangle &a, const geometry::CompactRectangle &b) -> bool
+    {
+        return geometry::getDistance(a, b) < minSpacing;
+    };
+    auto getNearIdxs = [&](const geometry::CompactRectangle &filler, const TileIndex &index, std::vector<uint32_t> &idxs)
+    {
+        idxs.clear();
+        auto [rowBegin, rowEnd, colBegin, colEnd] = getTileRange(filler, minSpacing);
+        for (size_t rowIdx = rowBegin; rowIdx < rowEnd; ++rowIdx)
+            for (size_t colIdx = colBegin; colIdx < colEnd; ++colIdx)
+            {
+                size_t tileIdx = rowIdx * numTileCol + colIdx;
+                idxs.insert(idxs.end(), index.idxs.begin() + index.begins[tileIdx], index.idxs.begin() + index.begins[tileIdx + 1]);
+            }
+        std::sort(idxs.begin(), idxs.end());
+        idxs.erase(std::unique(idxs.begin(), idxs.end()), idxs.end());
+    };
+
+    size_t numViolation = 0;
+    std::vector<uint32_t> idxs;
+    for (size_t fillerIdx = 0; fillerIdx < fillers.size(); ++fillerIdx)
+    {
+        const geometry::CompactRectangle &filler = fillers[fillerIdx];
+        getNearIdxs(filler, conductorIndex, idxs);
+        for (uint32_t conductorIdx : idxs)
+        {
+            if (!isTooClose(conductors[conductorIdx], filler))
+                continue;
+            output << "In layer " << layer.id << ", " << toString(conductors[conductorIdx]) << " and " << toString(filler)
+                   << " violates minimum spacing constraint!\n";
+            ++numViolation;
+        }
+        // a pair of fillers is reported from both sides, as the prebuilt verifier does
+        getNearIdxs(filler, fillerIndex, idxs);
+        for (uint32_t otherIdx : idxs)
+        {
+            if (otherIdx == fillerIdx || !isTooClose(fillers[otherIdx], filler))
+                continue;
+            output << "In layer " << layer.id << ", " << toString(fillers[otherIdx]) << " and " << toString(filler)
+                   << " violates minimum spacing constraint!\n";
+            ++numViolation;
+        }
+    }
+    return numViolation;
+}
+
+size_t Verifier::checkDensity(const process::Layer &layer, const std::vector<geometry::CompactRectangle> &conductors,
+                              const std::vector<geometry::CompactRectangle> &fillers, const TileIndex &conductorIndex,
+                              const TileIndex &fillerIndex, std::ostream &output) const
+{
+    // metal area of every tile as prefix sums, the union of the conductors and the fillers in it
+    std::vector<std::vector<int64_t>> prefixArea(numTileRow + 1, std::vector<int64_t>(numTileCol + 1, 0));
+    std::vector<geometry::CompactRectangle> clipped;
+    for (size_t rowIdx = 0; rowIdx < numTileRow; ++rowIdx)
+    {
+        for (size_t colIdx = 0; colIdx < numTileCol; ++colIdx)
+        {
+            geometry::CompactRectangle tile(db->chipBoundary.x1 + colIdx * tileSize, db->chipBoundary.y1 + rowIdx * tileSize,
+                                            db->chipBoundary.x1 + (colIdx + 1) * tileSize, db->chipBoundary.y1 + (rowIdx + 1) * tileSize);
+            size_t tileIdx = rowIdx * numTileCol + colIdx;
+            clipped.clear();
+            for (uint32_t i = conductorIndex.begins[tileIdx]; i < conductorIndex.begins[tileIdx + 1]; ++i)
+                if (geometry::isIntersect(tile, conductors[conductorIndex.idxs[i]]))
+                    clipped.emplace_back(geometry::getIntersectRegion(tile, conductors[conductorIndex.idxs[i]]));
+            for (uint32_t i = fillerIndex.begins[tileIdx]; i < fillerIndex.begins[tileIdx + 1]; ++i)
+                if (geometry::isIntersect(tile, fillers[fillerIndex.idxs[i]]))
+                    clipped.emplace_back(geometry::getIntersectRegion(tile, fillers[fillerIndex.idxs[i]]));
+            int64_t area = getUnionArea(clipped);
+            prefixArea[rowIdx + 1][colIdx + 1] = area + prefixArea[rowIdx][colIdx + 1] + prefixArea[rowIdx + 1][colIdx] - prefixArea[rowIdx][colIdx];
+        }
+    }
+
+    size_t windowBeginRow = (db->windowBoundary.y1 - db->chipBoundary.y1) / tileSize;
+    size_t windowBeginCol = (db->windowBoundary.x1 - db->chipBoundary.x1) / tileSize;
+    int64_t numWindowRow = db->windowBoundary.height() / tileSize - DensityManager::numStepForWindow + 1;
+    int64_t numWindowCol = db->windowBoundary.width() / tileSize - DensityManager::numStepForWindow + 1;
+    double windowArea = static_cast<double>(db->windowSize) * db->windowSize;
+    // the prebuilt prints the density of its first layer with 6 significant digits, and with 6 decimals after
+    // its first capacitance output has left the stream fixed
+    bool isFixed = (&layer != db->layers.front().get());
+    size_t numViolation = 0;
+    for (int64_t i = 0; i < numWindowCol; ++i)
+    {
+        for (int64_t j = 0; j < numWindowRow; ++j)
+        {
+            size_t colBegin = windowBeginCol + i, colEnd = colBegin + DensityManager::numStepForWindow;
+            size_t rowBegin = windowBeginRow + j, rowEnd = rowBegin + DensityManager::numStepForWindow;
+            int64_t area = prefixArea[rowEnd][colEnd] - prefixArea[rowBegin][colEnd] - prefixArea[rowEnd][colBegin] + prefixArea[rowBegin][colBegin];
+            double density = area / windowArea;
+            const char *bound = (density < layer.minMetalDensity) ? "minimum" : (density > layer.maxMetalDensity) ? "maximum"
+                                                                                                                 : nullptr;
+            if (!bound)
+                continue;
+            geometry::Rectangle window(db->chipBoundary.x1 + colBegin * tileSize, db->chipBoundary.y1 + rowBegin * tileSize,
+                                       db->chipBoundary.x1 + colBegin * tileSize + db->windowSize, db->chipBoundary.y1 + rowBegin * tileSize + db->windowSize);
+            window.shift(db->originX, db->originY);
+            output << "In layer " << layer.id << ", Window (" << window.x1 << ", " << window.y1 << ", " << window.x2 << ", " << window.y2
+                   << ") violates " << bound << " metal density constraint! (Your density: ";
+            if (isFixed)
+                output << std::fixed;
+            output << std::setprecision(6) << density << ")\n";
+            ++numViolation;
+        }
+    }
+    return numViolation;
+}
+
+size_t Verifier::checkLayer(const process::Layer &layer, const std::vector<geometry::CompactRectangle> &fillers, std::ostream &output) const
+{
+    PROFILE_ZONE("verify layer", layer.id);
+    std::vector<geometry::CompactRectangle> conductors;
+    conductors.reserve(layer.conductors.size());
+    for (size_t i = 0; i < layer.conductors.size(); ++i)
+        conductors.emplace_back(layer.conductors[i]);
+
+    // the fillers entirely outside the chip or with illegal coordinates are only reported, not placed
+    output << "Checking layer " << layer.id << "...\n";
+    std::vector<geometry::CompactRectangle> placedFillers;
+    size_t numViolation = checkFiller(layer, fillers, placedFillers, output);
+    TileIndex conductorIndex = buildIndex(conductors), fillerIndex = buildIndex(placedFillers);
+    numViolation += checkSpacing(layer, conductors, placedFillers, conductorIndex, fillerIndex, output);
+    numViolation += checkDensity(layer, conductors, placedFillers, conductorIndex, fillerIndex, output);
+    output << "Finish checking layer " << layer.id << "\n"
+           << "-------------------\n";
+    return numViolation;
+}
+
+size_t Verifier::verify(const std::map<int64_t, std::vector<geometry::CompactRectangle>> &layerToFillers, std::ostream &output) const
+{
+    PROFILE_ZONE("verify");
+    // each thread takes the next unchecked layer, the reports are printed in the layer order
+    const std::vector<geometry::CompactRectangle> noFiller;
+    std::vector<std::ostringstream> reports(db->layers.size());
+    std::vector<size_t> numViolations(db->layers.size(), 0);
+    std::atomic<size_t> nextLayerIdx(0);
+    auto run = [&]()
+    {
+        for (size_t layerIdx = nextLayerIdx++; layerIdx < db->layers.size(); layerIdx = nextLayerIdx++)
+        {
+            const process::Layer &layer = *db->layers[layerIdx];
+            auto it = layerToFillers.find(layer.id);
+            numViolations[layerIdx] = checkLayer(layer, (it != layerToFillers.end()) ? it->second : noFiller, reports[layerIdx]);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t threadIdx = 1; threadIdx < std::min(numThread, db->layers.size()); ++threadIdx)
+        threads.emplace_back(run);
+    run();
+    for (std::thread &thread : threads)
+        thread.join();
+
+    size_t numViolation = 0;
+    for (size_t layerIdx = 0; layerIdx < db->layers.size(); ++layerIdx)
+    {
+        output << reports[layerIdx].str();
+        numViolation += numViolations[layerIdx];
+    }
+    output << "#violations: " << numViolation << "\n";
+    return numViolation;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include "../Structure/Geometry/Geometry.hpp"
+#include "../Structure/Process/Process.hpp"
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// Checks the fillers of a solution against the layer rules with the
+// messages of the prebuilt verifier (verifier/verifier), without the
+// capacitance. The rectangles are bucketed by the tiles of the window step,
+// which serve both as the spatial index of the spacing check and as the
+// cells of the window density prefix sums. The layers are checked in parallel.
+class Verifier
+{
+    const process::Database *db;
+    size_t numThread;
+    int64_t tileSize; // window size / 4, the window step
+    size_t numTileRow, numTileCol;
+
+    // indices of the rectangles touching each tile, row-major and compressed
+    struct TileIndex
+    {
+        std::vector<uint32_t> begins, idxs;
+    };
+
+    std::tuple<size_t, size_t, size_t, size_t> getTileRange(const geometry::CompactRectangle &rectangle, int64_t margin) const;
+    TileIndex buildIndex(const std::vector<geometry::CompactRectangle> &rectangles) const;
+    std::string toString(const geometry::CompactRectangle &rectangle) const; // "(x1 y1 x2 y2)" in the input coordinates
+    static int64_t getUnionArea(const std::vector<geometry::CompactRectangle> &rectangles);
+
+    // the width and boundary checks, the legal fillers reaching into the chip are added to placedFillers
+    size_t checkFiller(const process::Layer &layer, const std::vector<geometry::CompactRectangle> &fillers,
+                       std::vector<geometry::CompactRectangle> &placedFillers, std::ostream &output) const;
+    size_t checkSpacing(const process::Layer &layer, const std::vector<geometry::CompactRectangle> &conductors,
+                        const std::vector<geometry::CompactRectangle> &fillers, const TileIndex &conductorIndex,
+                        const TileIndex &fillerIndex, std::ostream &output) const;
+    size_t checkDensity(const process::Layer &layer, const std::vector<geometry::CompactRectangle> &conductors,
+                        const std::vector<geometry::CompactRectangle> &fillers, const TileIndex &conductorIndex,
+                        const TileIndex &fillerIndex, std::ostream &output) const;
+    size_t checkLayer(const process::Layer &layer, const std::vector<geometry::CompactRectangle> &fillers, std::ostream &output) const;
+
+public:
+    Verifier(const process::Database *db_, size_t numThread_ = 1);
+    // fillers in the chip-relative coordinates of the database, keyed by layer id; returns #violations
+    size_t verify(const std::map<int64_t, std::vector<geometry::CompactRectangle>> &layerToFillers, std::ostream &output) const;
+};
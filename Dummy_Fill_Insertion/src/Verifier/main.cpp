@@ -0,0 +1,41 @@
+#include "../Parser/Parser.hpp"
+#include "Verifier.hpp"
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <unistd.h>
+
+int main(int argc, char *argv[])
+{
+    size_t numThread = std::max(std::thread::hardware_concurrency(), 1u);
+    int opt;
+    while ((opt = getopt(argc, argv, "hj:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'j':
+            numThread = std::atoi(optarg);
+            break;
+        default:
+            optind = argc + 1;
+            break;
+        }
+    }
+    if (argc - optind != 2 || numThread == 0)
+    {
+        std::cerr << "Usage: " << argv[0] << " [-j <#threads>] <input file> <output file>\n";
+        return 1;
+    }
+
+    // the fillers of the output file become the previous fillers of their layers
+    Parser parser;
+    if (!parser.parse(argv[optind]) || !parser.parseFiller(argv[optind + 1]))
+        return 1;
+    process::Database::ptr db = parser.createDatabase();
+    std::map<int64_t, std::vector<geometry::CompactRectangle>> layerToFillers;
+    for (const process::Layer::ptr &layer : db->layers)
+        layerToFillers[layer->id] = layer->previousFillers;
+
+    Verifier verifier(db.get(), numThread);
+    return (verifier.verify(layerToFillers, std::cout) == 0) ? 0 : 1;
+}
@@ -1,40 +1,161 @@
+#include "Coordinator/Coordinator.hpp"
 #include "DensityManager/DensityManager.hpp"
+#include "MemoryTracker/MemoryReport.hpp"
+#include "MemoryTracker/MemoryTracker.hpp"
 #include "Parser/ArgumentParser.hpp"
 #include "Parser/Parser.hpp"
+#include "StripeSolver/StripeSolver.hpp"
+#include "Timer/Profiler.hpp"
+#include "Timer/Progress.hpp"
 #include "Timer/Timer.hpp"
+#include "Verifier/Verifier.hpp"
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
 
-int main(int argc, char *argv[])
+// out-of-core mode: the conductors go to disk while parsing and the chip is solved stripe by stripe
+int solveStripe(const ArgumentParser &argParser, Timer &timer)
 {
-    ArgumentParser argParser;
-    if (!argParser.parse(argc, argv))
+    Parser parser;
+    StripeStore stripeStore(argParser.numTileForWindow, argParser.numWindowPerStripe);
+    {
+        PROFILE_ZONE("parse input");
+        Progress::Phase progress("parse input");
+        if (!parser.parse(argParser.inputFilepath, stripeStore))
+            return 1;
+        parser.recordMemory();
+        MemoryReport::takeSnapshot("parse input");
+    }
+    if (!DensityManager::isValidNumTileForWindow(stripeStore.getWindowSize(), argParser.numTileForWindow))
+    {
+        std::cerr << "[Error] #tiles per window side must be a multiple of " << DensityManager::numStepForWindow
+                  << " and divide the window size.\n";
         return 1;
+    }
 
-    Timer timer(10 * 60 - 10);
-    timer.startTimer("runtime");
-    timer.startTimer("parse input");
+    PROFILE_ZONE("processing");
+    StripeSolver stripeSolver(&parser, &stripeStore, argParser.numTileForWindow, &timer);
+    if (!stripeSolver.solve(argParser.outputFilepath))
+        return 1;
+    return 0;
+}
 
+int solve(const ArgumentParser &argParser, Timer &timer)
+{
     Parser parser;
-    if (!parser.parse(argParser.inputFilepath))
-        return 1;
-    process::Database::ptr db = parser.createDatabase();
+    process::Database::ptr db;
+    {
+        PROFILE_ZONE("parse input");
+        Progress::Phase progress("parse input");
+        if (!parser.parse(argParser.inputFilepath))
+            return 1;
+        if (argParser.isIncremental())
+        {
+            if (!parser.parseFiller(argParser.previousOutputFilepath))
+                return 1;
+            if (!parser.parseDelta(argParser.deltaFilepath))
+                return 1;
+        }
+        db = parser.createDatabase();
+        db->isIncremental = argParser.isIncremental();
+        parser.recordMemory(db.get());
+        MemoryReport::takeSnapshot("parse input");
+    }
 
-    timer.stopTimer("parse input");
-    timer.startTimer("processing");
+    ResultWriter::ptr result;
+    {
+        PROFILE_ZONE("processing");
+        size_t numTileForWindow = argParser.numTileForWindow;
+        if (numTileForWindow == 0)
+        {
+            numTileForWindow = DensityManager::getAutoNumTileForWindow(db.get());
+        }
+        else if (!DensityManager::isValidNumTileForWindow(db->windowSize, numTileForWindow))
+        {
+            std::cerr << "[Error] #tiles per window side must be a multiple of " << DensityManager::numStepForWindow
+                      << " and divide the window size.\n";
+            return 1;
+        }
 
-    DensityManager densityManager(db.get());
-    ResultWriter::ptr result = densityManager.solve();
+        if (argParser.isMultiProcess())
+        {
+            Coordinator coordinator(&parser, db.get(), numTileForWindow, argParser.numWorker, &timer);
+            result = coordinator.solve();
+        }
+        else
+        {
+            DensityManager densityManager(db.get(), numTileForWindow, &timer, argParser.numThread);
+            if (!argParser.rasterPrefix.empty())
+                densityManager.setRaster(argParser.rasterPrefix, argParser.rasterResolution, argParser.isRasterCoverage);
+            result = densityManager.solve();
+        }
+        result->recordMemory();
+        MemoryReport::takeSnapshot("processing");
+    }
 
-    timer.stopTimer("processing");
-    timer.startTimer("write output");
+    {
+        PROFILE_ZONE("write output");
+        Progress::Phase progress("write output");
+        result->write(argParser.outputFilepath);
+        MemoryReport::takeSnapshot("write output");
+    }
 
-    result->write(argParser.outputFilepath);
+    if (argParser.isSelfCheck)
+    {
+        PROFILE_ZONE("self-check");
+        Progress::Phase progress("self-check");
+        std::cout << "----- SELF-CHECK -----\n";
+        Verifier verifier(db.get(), argParser.numThread);
+        size_t numViolation = verifier.verify(result->getLayerToFillers(), std::cout);
+        std::cout << "\n";
+        if (numViolation > 0)
+        {
+            std::cerr << "[Error] Self-check found " << numViolation << " violations.\n";
+            return 1;
+        }
+    }
+    return 0;
+}
 
-    timer.stopTimer("write output");
-    timer.stopTimer("runtime");
+int main(int argc, char *argv[])
+{
+    ArgumentParser argParser;
+    if (!argParser.parse(argc, argv))
+        return 1;
+
+    if (argParser.isCountingHardware)
+        Profiler::enableCounters();
+
+    // the status file is rewritten every second if no interval is given
+    if (argParser.isReportingProgress() &&
+        !Progress::start(std::chrono::milliseconds(argParser.progressInterval > 0 ? static_cast<int64_t>(argParser.progressInterval * 1000) : 1000),
+                         argParser.progressInterval > 0, argParser.statusFilepath))
+        return 1;
+
+    Timer timer(argParser.timeLimit);
+    {
+        PROFILE_ZONE("runtime");
+        int status = argParser.isStripe() ? solveStripe(argParser, timer) : solve(argParser, timer);
+        Progress::stop();
+        if (status != 0)
+            return status;
+    }
+
+    Profiler::printBreakdown(std::cout);
+    Profiler::printCounters(std::cout);
+    MemoryReport::printPeak(std::cout);
+    if (!argParser.memoryFilepath.empty() && !MemoryReport::writeJson(argParser.memoryFilepath))
+        return 1;
+    if (!argParser.traceFilepath.empty() && !Profiler::writeTrace(argParser.traceFilepath))
+        return 1;
 
-    timer.printTime("parse input");
-    timer.printTime("processing");
-    timer.printTime("write output");
-    timer.printTime("runtime");
+    std::vector<std::string> tags = {"parse input", "processing", "write output"};
+    if (argParser.isStripe())
+        tags.pop_back(); // the stripes are written while solving
+    for (const std::string &tag : tags)
+        std::cout << std::setw(14) << std::left << tag + ":" << Profiler::getSecond("runtime/" + tag) << " s\n";
+    std::cout << std::setw(14) << std::left << "runtime:" << Profiler::getSecond("runtime") << " s\n";
+    std::cout << "peak memory:  " << MemoryTracker::getPeakMemory() / 1024.0 << " MB\n";
     return 0;
 }